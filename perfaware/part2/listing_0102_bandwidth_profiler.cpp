@@ -0,0 +1,279 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 102
+   ======================================================================== */
+
+#include "listing_0074_platform_metrics.cpp"
+
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+#ifndef READ_BLOCK_TIMER
+#define READ_BLOCK_TIMER ReadCPUTimer
+#endif
+
+#ifndef MAX_PROFILER_THREADS
+#define MAX_PROFILER_THREADS 64
+#endif
+
+#if PROFILER
+
+#include <atomic>
+
+struct profile_anchor
+{
+    u64 TSCElapsedExclusive; // NOTE: Does NOT include children
+    u64 TSCElapsedInclusive; // NOTE: DOES include children
+    u64 HitCount;
+    u64 ProcessedByteCount;
+    char const *Label;
+};
+
+/* NOTE: Every thread that enters a profile block gets its own anchor table and its own
+   parent index, so blocks on different threads never touch the same counters and the
+   parent chain of one thread cannot be broken by another. The tables live in a global
+   array rather than in thread_local storage so that they are still around when the
+   threads have exited and EndAndPrintProfile merges them. */
+struct profile_thread
+{
+    profile_anchor Anchors[4096];
+    u32 ParentIndex;
+};
+static profile_thread GlobalProfilerThreads[MAX_PROFILER_THREADS];
+static std::atomic<u32> GlobalProfilerThreadCount;
+static thread_local profile_thread *GlobalProfilerThread;
+
+static profile_thread *GetProfilerThread(void)
+{
+    profile_thread *Result = GlobalProfilerThread;
+    if(!Result)
+    {
+        /* NOTE: If there are more threads than tables, the extra threads share the last
+           table. Their numbers will be garbage, but EndAndPrintProfile warns about it. */
+        u32 ThreadIndex = GlobalProfilerThreadCount++;
+        if(ThreadIndex >= MAX_PROFILER_THREADS)
+        {
+            ThreadIndex = MAX_PROFILER_THREADS - 1;
+        }
+        
+        Result = GlobalProfilerThreads + ThreadIndex;
+        GlobalProfilerThread = Result;
+    }
+    
+    return Result;
+}
+
+struct profile_block
+{
+    profile_block(char const *Label_, u32 AnchorIndex_, u64 ByteCount)
+    {
+        Thread = GetProfilerThread();
+        ParentIndex = Thread->ParentIndex;
+        
+        AnchorIndex = AnchorIndex_;
+        Label = Label_;
+
+        profile_anchor *Anchor = Thread->Anchors + AnchorIndex;
+        OldTSCElapsedInclusive = Anchor->TSCElapsedInclusive;
+        Anchor->ProcessedByteCount += ByteCount;
+        
+        Thread->ParentIndex = AnchorIndex;
+        StartTSC = READ_BLOCK_TIMER();
+    }
+    
+    ~profile_block(void)
+    {
+        u64 Elapsed = READ_BLOCK_TIMER() - StartTSC;
+        Thread->ParentIndex = ParentIndex;
+    
+        profile_anchor *Parent = Thread->Anchors + ParentIndex;
+        profile_anchor *Anchor = Thread->Anchors + AnchorIndex;
+        
+        Parent->TSCElapsedExclusive -= Elapsed;
+        Anchor->TSCElapsedExclusive += Elapsed;
+        Anchor->TSCElapsedInclusive = OldTSCElapsedInclusive + Elapsed;
+        ++Anchor->HitCount;
+        
+        /* NOTE(casey): This write happens every time solely because there is no
+           straightforward way in C++ to have the same ease-of-use. In a better programming
+           language, it would be simple to have the anchor points gathered and labeled at compile
+           time, and this repetative write would be eliminated. */
+        Anchor->Label = Label;
+    }
+    
+    profile_thread *Thread;
+    char const *Label;
+    u64 OldTSCElapsedInclusive;
+    u64 StartTSC;
+    u32 ParentIndex;
+    u32 AnchorIndex;
+};
+
+#define NameConcat2(A, B) A##B
+#define NameConcat(A, B) NameConcat2(A, B)
+#define TimeBandwidth(Name, ByteCount) profile_block NameConcat(Block, __LINE__)(Name, __COUNTER__ + 1, ByteCount)
+#define TimeBlock(Name) TimeBandwidth(Name, 0)
+#define ProfilerEndOfCompilationUnit static_assert(__COUNTER__ < ArrayCount(GlobalProfilerThreads[0].Anchors), "Number of profile points exceeds size of profiler::Anchors array")
+
+static void PrintTimeElapsed(u64 TotalTSCElapsed, u64 TimerFreq, profile_anchor *Anchor)
+{
+    f64 Percent = 100.0 * ((f64)Anchor->TSCElapsedExclusive / (f64)TotalTSCElapsed);
+    printf("  %s[%llu]: %llu (%.2f%%", Anchor->Label, Anchor->HitCount, Anchor->TSCElapsedExclusive, Percent);
+    if(Anchor->TSCElapsedInclusive != Anchor->TSCElapsedExclusive)
+    {
+        f64 PercentWithChildren = 100.0 * ((f64)Anchor->TSCElapsedInclusive / (f64)TotalTSCElapsed);
+        printf(", %.2f%% w/children", PercentWithChildren);
+    }
+    printf(")");
+    
+    /* NOTE: Bandwidth is measured against the inclusive time, since the bytes are
+       processed by the block as a whole, including whatever it calls to do it. */
+    if(Anchor->ProcessedByteCount && TimerFreq)
+    {
+        f64 Megabyte = 1024.0*1024.0;
+        f64 Gigabyte = Megabyte*1024.0;
+        
+        f64 Seconds = (f64)Anchor->TSCElapsedInclusive / (f64)TimerFreq;
+        f64 BytesPerSecond = (f64)Anchor->ProcessedByteCount / Seconds;
+        f64 Megabytes = (f64)Anchor->ProcessedByteCount / Megabyte;
+        
+        printf("  %.3fmb at %.2fmb/s (%.2fgb/s)", Megabytes, BytesPerSecond / Megabyte, BytesPerSecond / Gigabyte);
+    }
+    printf("\n");
+}
+
+static void PrintAnchorData(u64 TotalTSCElapsed, u64 TimerFreq)
+{
+    u32 ThreadCount = GlobalProfilerThreadCount;
+    if(ThreadCount > MAX_PROFILER_THREADS)
+    {
+        printf("WARNING: %u threads were profiled, but there are only tables for %u. The last table is unreliable.\n",
+               ThreadCount, MAX_PROFILER_THREADS);
+        ThreadCount = MAX_PROFILER_THREADS;
+    }
+    
+    /* NOTE: Anchors are identified by the same index on every thread, so merging is just
+       summing the tables. A time in the merged table is the sum over all threads, which
+       means its percentage of the total wall time can be above 100% when threads overlap. */
+    static profile_anchor Merged[ArrayCount(GlobalProfilerThreads[0].Anchors)];
+    for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profile_thread *Thread = GlobalProfilerThreads + ThreadIndex;
+        
+        if(ThreadCount > 1)
+        {
+            printf("\nThread %u:\n", ThreadIndex);
+        }
+        
+        for(u32 AnchorIndex = 0; AnchorIndex < ArrayCount(Thread->Anchors); ++AnchorIndex)
+        {
+            profile_anchor *Anchor = Thread->Anchors + AnchorIndex;
+            if(Anchor->TSCElapsedInclusive)
+            {
+                PrintTimeElapsed(TotalTSCElapsed, TimerFreq, Anchor);
+                
+                profile_anchor *Sum = Merged + AnchorIndex;
+                Sum->TSCElapsedExclusive += Anchor->TSCElapsedExclusive;
+                Sum->TSCElapsedInclusive += Anchor->TSCElapsedInclusive;
+                Sum->HitCount += Anchor->HitCount;
+                Sum->ProcessedByteCount += Anchor->ProcessedByteCount;
+                Sum->Label = Anchor->Label;
+            }
+        }
+    }
+    
+    if(ThreadCount > 1)
+    {
+        printf("\nAll threads (summed, percentages of wall time):\n");
+        for(u32 AnchorIndex = 0; AnchorIndex < ArrayCount(Merged); ++AnchorIndex)
+        {
+            profile_anchor *Anchor = Merged + AnchorIndex;
+            if(Anchor->TSCElapsedInclusive)
+            {
+                PrintTimeElapsed(TotalTSCElapsed, TimerFreq, Anchor);
+            }
+        }
+    }
+}
+
+#else
+
+#define TimeBlock(...)
+#define TimeBandwidth(...)
+#define PrintAnchorData(...)
+#define ProfilerEndOfCompilationUnit
+
+#endif
+
+struct profiler
+{
+    u64 StartTSC;
+    u64 EndTSC;
+};
+static profiler GlobalProfiler;
+
+#define TimeFunction TimeBlock(__func__)
+
+static u64 EstimateBlockTimerFreq(void)
+{
+    (void)&EstimateCPUTimerFreq; // NOTE(casey): This has to be voided here to prevent compilers from warning us that it is not used
+    
+	u64 MillisecondsToWait = 100;
+	u64 OSFreq = GetOSTimerFreq();
+
+	u64 BlockStart = READ_BLOCK_TIMER();
+	u64 OSStart = ReadOSTimer();
+	u64 OSEnd = 0;
+	u64 OSElapsed = 0;
+	u64 OSWaitTime = OSFreq * MillisecondsToWait / 1000;
+	while(OSElapsed < OSWaitTime)
+	{
+		OSEnd = ReadOSTimer();
+		OSElapsed = OSEnd - OSStart;
+	}
+	
+	u64 BlockEnd = READ_BLOCK_TIMER();
+	u64 BlockElapsed = BlockEnd - BlockStart;
+	
+	u64 BlockFreq = 0;
+	if(OSElapsed)
+	{
+		BlockFreq = OSFreq * BlockElapsed / OSElapsed;
+	}
+	
+	return BlockFreq;
+}
+
+static void BeginProfile(void)
+{
+    GlobalProfiler.StartTSC = READ_BLOCK_TIMER();
+}
+
+/* NOTE: All threads that were profiled have to be finished (joined) before this is called,
+   otherwise their tables are read while they are still being written. */
+static void EndAndPrintProfile()
+{
+    GlobalProfiler.EndTSC = READ_BLOCK_TIMER();
+    u64 TimerFreq = EstimateBlockTimerFreq();
+    
+    u64 TotalTSCElapsed = GlobalProfiler.EndTSC - GlobalProfiler.StartTSC;
+    
+    if(TimerFreq)
+    {
+        printf("\nTotal time: %0.4fms (timer freq %llu)\n", 1000.0 * (f64)TotalTSCElapsed / (f64)TimerFreq, TimerFreq);
+    }
+    
+    PrintAnchorData(TotalTSCElapsed, TimerFreq);
+}
@@ -0,0 +1,326 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 106
+   ======================================================================== */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+
+#if _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+enum allocation_type
+{
+    AllocType_none,
+    AllocType_malloc,
+    
+    AllocType_Count,
+};
+
+struct read_parameters
+{
+    allocation_type AllocType;
+    buffer Dest;
+    char const *FileName;
+};
+
+typedef void read_overhead_test_func(repetition_tester *Tester, read_parameters *Params);
+
+static char const *DescribeAllocationType(allocation_type AllocType)
+{
+    char const *Result;
+    switch(AllocType)
+    {
+        case AllocType_none: {Result = "";} break;
+        case AllocType_malloc: {Result = "malloc";} break;
+        default : {Result = "UNKNOWN";} break;
+    }
+    
+    return Result;
+}
+
+/* NOTE: With AllocType_none every repetition reads into the same buffer, which was
+   allocated and touched once up front. With AllocType_malloc every repetition gets a
+   fresh buffer, so the cost of the OS handing us new pages shows up in the timing and
+   in the page fault count, just like it would when loading a file once for real. */
+static void HandleAllocation(read_parameters *Params, buffer *Buffer)
+{
+    switch(Params->AllocType)
+    {
+        case AllocType_none:
+        {
+        } break;
+        
+        case AllocType_malloc:
+        {
+            *Buffer = AllocateBuffer(Params->Dest.Count);
+        } break;
+        
+        default:
+        {
+            fprintf(stderr, "ERROR: Unrecognized allocation type");
+        } break;
+    }
+}
+
+static void HandleDeallocation(read_parameters *Params, buffer *Buffer)
+{
+    switch(Params->AllocType)
+    {
+        case AllocType_none:
+        {
+        } break;
+        
+        case AllocType_malloc:
+        {
+            FreeBuffer(Buffer);
+        } break;
+        
+        default:
+        {
+            fprintf(stderr, "ERROR: Unrecognized allocation type");
+        } break;
+    }
+}
+
+static void ReadViaFRead(repetition_tester *Tester, read_parameters *Params)
+{
+    while(IsTesting(Tester))
+    {
+        FILE *File = fopen(Params->FileName, "rb");
+        if(File)
+        {
+            buffer DestBuffer = Params->Dest;
+            HandleAllocation(Params, &DestBuffer);
+            
+            BeginTime(Tester);
+            size_t Result = fread(DestBuffer.Data, DestBuffer.Count, 1, File);
+            EndTime(Tester);
+            
+            if(Result == 1)
+            {
+                CountBytes(Tester, DestBuffer.Count);
+            }
+            else
+            {
+                Error(Tester, "fread failed");
+            }
+            
+            HandleDeallocation(Params, &DestBuffer);
+            fclose(File);
+        }
+        else
+        {
+            Error(Tester, "fopen failed");
+        }
+    }
+}
+
+static void ReadViaRead(repetition_tester *Tester, read_parameters *Params)
+{
+    while(IsTesting(Tester))
+    {
+#if _WIN32
+        int File = _open(Params->FileName, _O_BINARY|_O_RDONLY);
+#else
+        int File = open(Params->FileName, O_RDONLY);
+#endif
+        if(File != -1)
+        {
+            buffer DestBuffer = Params->Dest;
+            HandleAllocation(Params, &DestBuffer);
+            
+            u8 *Dest = DestBuffer.Data;
+            u64 SizeRemaining = DestBuffer.Count;
+            while(SizeRemaining)
+            {
+                /* NOTE: Neither _read nor read can be asked for more than a couple of
+                   gigabytes at once, so large files are read in pieces. */
+                u32 ReadSize = INT_MAX;
+                if((u64)ReadSize > SizeRemaining)
+                {
+                    ReadSize = (u32)SizeRemaining;
+                }
+
+                BeginTime(Tester);
+#if _WIN32
+                int Result = _read(File, Dest, ReadSize);
+#else
+                ssize_t Result = read(File, Dest, ReadSize);
+#endif
+                EndTime(Tester);
+
+                if(Result > 0)
+                {
+                    CountBytes(Tester, (u64)Result);
+                }
+                else
+                {
+                    Error(Tester, "read failed");
+                    break;
+                }
+                
+                SizeRemaining -= (u64)Result;
+                Dest += Result;
+            }
+            
+            HandleDeallocation(Params, &DestBuffer);
+#if _WIN32
+            _close(File);
+#else
+            close(File);
+#endif
+        }
+        else
+        {
+            Error(Tester, "open failed");
+        }
+    }
+}
+
+#if _WIN32
+
+static void ReadViaReadFile(repetition_tester *Tester, read_parameters *Params)
+{
+    while(IsTesting(Tester))
+    {
+        HANDLE File = CreateFileA(Params->FileName, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE, 0,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        if(File != INVALID_HANDLE_VALUE)
+        {
+            buffer DestBuffer = Params->Dest;
+            HandleAllocation(Params, &DestBuffer);
+            
+            u64 SizeRemaining = Params->Dest.Count;
+            u8 *OutPtr = (u8 *)DestBuffer.Data;
+            while(SizeRemaining)
+            {
+                u32 ReadSize = (u32)-1;
+                if((u64)ReadSize > SizeRemaining)
+                {
+                    ReadSize = (u32)SizeRemaining;
+                }
+                
+                DWORD BytesRead = 0;
+                BeginTime(Tester);
+                BOOL Result = ReadFile(File, OutPtr, ReadSize, &BytesRead, 0);
+                EndTime(Tester);
+                
+                if(Result && (BytesRead == ReadSize))
+                {
+                    CountBytes(Tester, ReadSize);
+                }
+                else
+                {
+                    Error(Tester, "ReadFile failed");
+                }
+                
+                SizeRemaining -= ReadSize;
+                OutPtr += ReadSize;
+            }
+            
+            HandleDeallocation(Params, &DestBuffer);
+            CloseHandle(File);
+        }
+        else
+        {
+            Error(Tester, "CreateFileA failed");
+        }
+    }
+}
+
+#endif
+
+/* NOTE: Mapping the file by itself does not load anything, the pages only come in when they
+   are touched. So that this test does the same work as the others, the mapped file is copied
+   into the destination buffer, and both the mapping and the copy are timed. */
+static void ReadViaMemoryMap(repetition_tester *Tester, read_parameters *Params)
+{
+    while(IsTesting(Tester))
+    {
+        buffer DestBuffer = Params->Dest;
+        HandleAllocation(Params, &DestBuffer);
+        
+#if _WIN32
+        HANDLE File = CreateFileA(Params->FileName, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE, 0,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        if(File != INVALID_HANDLE_VALUE)
+        {
+            BeginTime(Tester);
+            HANDLE Mapping = CreateFileMappingA(File, 0, PAGE_READONLY, 0, 0, 0);
+            void *Source = Mapping ? MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+            if(Source)
+            {
+                memcpy(DestBuffer.Data, Source, DestBuffer.Count);
+                UnmapViewOfFile(Source);
+            }
+            if(Mapping)
+            {
+                CloseHandle(Mapping);
+            }
+            EndTime(Tester);
+            
+            if(Source)
+            {
+                CountBytes(Tester, DestBuffer.Count);
+            }
+            else
+            {
+                Error(Tester, "MapViewOfFile failed");
+            }
+            
+            CloseHandle(File);
+        }
+        else
+        {
+            Error(Tester, "CreateFileA failed");
+        }
+#else
+        int File = open(Params->FileName, O_RDONLY);
+        if(File != -1)
+        {
+            BeginTime(Tester);
+            void *Source = mmap(0, DestBuffer.Count, PROT_READ, MAP_PRIVATE|MAP_POPULATE, File, 0);
+            if(Source != MAP_FAILED)
+            {
+                memcpy(DestBuffer.Data, Source, DestBuffer.Count);
+                munmap(Source, DestBuffer.Count);
+            }
+            EndTime(Tester);
+            
+            if(Source != MAP_FAILED)
+            {
+                CountBytes(Tester, DestBuffer.Count);
+            }
+            else
+            {
+                Error(Tester, "mmap failed");
+            }
+            
+            close(File);
+        }
+        else
+        {
+            Error(Tester, "open failed");
+        }
+#endif
+        
+        HandleDeallocation(Params, &DestBuffer);
+    }
+}
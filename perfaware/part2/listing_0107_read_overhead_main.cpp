@@ -0,0 +1,164 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 107
+   ======================================================================== */
+
+/* NOTE(casey): _CRT_SECURE_NO_WARNINGS is here because otherwise we cannot
+   call fopen(). If we replace fopen() with fopen_s() to avoid the warning,
+   then the code doesn't compile on Linux anymore, since fopen_s() does not
+   exist there.
+   
+   What exactly the CRT maintainers were thinking when they made this choice,
+   I have no idea. */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef int32_t b32;
+
+typedef float f32;
+typedef double f64;
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+#include "listing_0104_platform_metrics.cpp"
+#include "listing_0068_buffer.cpp"
+#include "listing_0105_repetition_tester.cpp"
+#include "listing_0106_read_overhead_test.cpp"
+
+struct test_function
+{
+    char const *Name;
+    read_overhead_test_func *Func;
+};
+test_function TestFunctions[] =
+{
+    {"fread", ReadViaFRead},
+    {"read", ReadViaRead},
+#if _WIN32
+    {"ReadFile", ReadViaReadFile},
+#endif
+    {"memory map", ReadViaMemoryMap},
+};
+
+int main(int ArgCount, char **Args)
+{
+    // NOTE: Since we do not use these functions in this particular build, we reference their pointers
+    // here to prevent the compiler from complaining about "unused functions".
+    (void)&IsInBounds;
+    (void)&AreEqual;
+    
+    int Result = 1;
+    
+    if((ArgCount == 2) || (ArgCount == 3))
+    {
+        char *FileName = Args[1];
+        u32 SecondsToTry = (ArgCount == 3) ? (u32)atoi(Args[2]) : 10;
+        
+        u64 CPUTimerFreq = EstimateCPUTimerFreq();
+        
+#if _WIN32
+        struct __stat64 Stat;
+        _stat64(FileName, &Stat);
+#else
+        struct stat Stat;
+        stat(FileName, &Stat);
+#endif
+        
+        read_parameters Params = {};
+        Params.Dest = AllocateBuffer(Stat.st_size);
+        Params.FileName = FileName;
+    
+        if(Params.Dest.Count > 0)
+        {
+            /* NOTE: The shared buffer is written once here, so the tests that reuse it
+               start out with all of its pages already mapped. */
+            memset(Params.Dest.Data, 0, Params.Dest.Count);
+            
+            repetition_tester Testers[ArrayCount(TestFunctions)][AllocType_Count] = {};
+            
+            for(u32 FuncIndex = 0; FuncIndex < ArrayCount(TestFunctions); ++FuncIndex)
+            {
+                for(u32 AllocType = 0; AllocType < AllocType_Count; ++AllocType)
+                {
+                    Params.AllocType = (allocation_type)AllocType;
+                    
+                    repetition_tester *Tester = &Testers[FuncIndex][AllocType];
+                    test_function TestFunc = TestFunctions[FuncIndex];
+                    
+                    printf("\n--- %s%s%s ---\n",
+                           DescribeAllocationType(Params.AllocType),
+                           Params.AllocType ? " + " : "",
+                           TestFunc.Name);
+                    NewTestWave(Tester, Params.Dest.Count, CPUTimerFreq, SecondsToTry);
+                    TestFunc.Func(Tester, &Params);
+                }
+            }
+            
+            /* NOTE: The summary only compares the minimums, since those are the runs that
+               tell us what each path is capable of. */
+            printf("\n--- Summary (min) ---\n");
+            repetition_tester *Fastest = 0;
+            char const *FastestName = 0;
+            allocation_type FastestAllocType = AllocType_none;
+            for(u32 FuncIndex = 0; FuncIndex < ArrayCount(TestFunctions); ++FuncIndex)
+            {
+                for(u32 AllocType = 0; AllocType < AllocType_Count; ++AllocType)
+                {
+                    repetition_tester *Tester = &Testers[FuncIndex][AllocType];
+                    if(Tester->Mode == TestMode_Completed)
+                    {
+                        char Label[64];
+                        snprintf(Label, sizeof(Label), "%8s%s%-10s", DescribeAllocationType((allocation_type)AllocType),
+                                 AllocType ? " + " : "   ", TestFunctions[FuncIndex].Name);
+                        PrintValue(Label, Tester->Results.Min, CPUTimerFreq);
+                        printf("\n");
+                        
+                        if(!Fastest || (Tester->Results.Min.E[RepValue_CPUTimer] < Fastest->Results.Min.E[RepValue_CPUTimer]))
+                        {
+                            Fastest = Tester;
+                            FastestName = TestFunctions[FuncIndex].Name;
+                            FastestAllocType = (allocation_type)AllocType;
+                        }
+                    }
+                }
+            }
+            
+            if(Fastest)
+            {
+                printf("\nFastest: %s%s%s\n", DescribeAllocationType(FastestAllocType),
+                       FastestAllocType ? " + " : "", FastestName);
+                Result = 0;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Test data size must be non-zero\n");
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s [existing filename]\n", Args[0]);
+        fprintf(stderr, "       %s [existing filename] [seconds to try]\n", Args[0]);
+    }
+    
+    return Result;
+}
@@ -0,0 +1,479 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 108
+   ======================================================================== */
+
+#include "listing_0074_platform_metrics.cpp"
+
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+#ifndef READ_BLOCK_TIMER
+#define READ_BLOCK_TIMER ReadCPUTimer
+#endif
+
+#ifndef MAX_PROFILER_THREADS
+#define MAX_PROFILER_THREADS 64
+#endif
+
+#ifndef MAX_PROFILER_PATHS
+#define MAX_PROFILER_PATHS 4096
+#endif
+
+#if PROFILER
+
+#include <atomic>
+
+struct profile_anchor
+{
+    u64 TSCElapsedExclusive; // NOTE: Does NOT include children
+    u64 TSCElapsedInclusive; // NOTE: DOES include children
+    u64 HitCount;
+    u64 ProcessedByteCount;
+    char const *Label;
+};
+
+/* NOTE: An anchor sums up everything that happened at one TimeBlock, no matter where it was
+   called from. To be able to print a call tree, each thread additionally keeps one path node
+   per distinct chain of blocks that led to a block. Path node 0 is the root. Children of a
+   node are kept in a singly linked list in the order they were first entered, and since a
+   block usually has very few distinct children, finding the right one on entry is a short
+   walk. A recursive call gets a new, deeper node, so a node can never be its own ancestor
+   and its inclusive time can simply be summed. */
+struct profile_path_node
+{
+    u64 TSCElapsedExclusive;
+    u64 TSCElapsedInclusive;
+    u64 HitCount;
+    u32 AnchorIndex;
+    u32 FirstChild;
+    u32 LastChild;
+    u32 NextSibling;
+};
+
+/* NOTE: Every thread that enters a profile block gets its own anchor table and its own
+   parent index, so blocks on different threads never touch the same counters and the
+   parent chain of one thread cannot be broken by another. The tables live in a global
+   array rather than in thread_local storage so that they are still around when the
+   threads have exited and EndAndPrintProfile merges them. */
+struct profile_thread
+{
+    profile_anchor Anchors[4096];
+    u32 ParentIndex;
+    
+    profile_path_node Paths[MAX_PROFILER_PATHS];
+    u32 PathCount;
+    u32 CurrentPath;
+    b32 PathsOverflowed;
+};
+static profile_thread GlobalProfilerThreads[MAX_PROFILER_THREADS];
+static std::atomic<u32> GlobalProfilerThreadCount;
+static thread_local profile_thread *GlobalProfilerThread;
+
+static u32 EnterProfilePath(profile_thread *Thread, u32 AnchorIndex)
+{
+    profile_path_node *Parent = Thread->Paths + Thread->CurrentPath;
+    
+    u32 Result = Parent->FirstChild;
+    while(Result && (Thread->Paths[Result].AnchorIndex != AnchorIndex))
+    {
+        Result = Thread->Paths[Result].NextSibling;
+    }
+    
+    if(!Result)
+    {
+        if(Thread->PathCount == 0)
+        {
+            // NOTE: Node 0 is the root, so the first real node is 1.
+            Thread->PathCount = 1;
+        }
+        
+        if(Thread->PathCount < MAX_PROFILER_PATHS)
+        {
+            Result = Thread->PathCount++;
+            profile_path_node *Node = Thread->Paths + Result;
+            Node->AnchorIndex = AnchorIndex;
+            
+            if(Parent->LastChild)
+            {
+                Thread->Paths[Parent->LastChild].NextSibling = Result;
+            }
+            else
+            {
+                Parent->FirstChild = Result;
+            }
+            Parent->LastChild = Result;
+        }
+        else
+        {
+            /* NOTE: When the table is full, the block stays on its parent's node and is
+               simply missing from the tree. The flat anchor data is still complete. */
+            Thread->PathsOverflowed = true;
+            Result = Thread->CurrentPath;
+        }
+    }
+    
+    return Result;
+}
+
+static profile_thread *GetProfilerThread(void)
+{
+    profile_thread *Result = GlobalProfilerThread;
+    if(!Result)
+    {
+        /* NOTE: If there are more threads than tables, the extra threads share the last
+           table. Their numbers will be garbage, but EndAndPrintProfile warns about it. */
+        u32 ThreadIndex = GlobalProfilerThreadCount++;
+        if(ThreadIndex >= MAX_PROFILER_THREADS)
+        {
+            ThreadIndex = MAX_PROFILER_THREADS - 1;
+        }
+        
+        Result = GlobalProfilerThreads + ThreadIndex;
+        GlobalProfilerThread = Result;
+    }
+    
+    return Result;
+}
+
+struct profile_block
+{
+    profile_block(char const *Label_, u32 AnchorIndex_, u64 ByteCount)
+    {
+        Thread = GetProfilerThread();
+        ParentIndex = Thread->ParentIndex;
+        
+        AnchorIndex = AnchorIndex_;
+        Label = Label_;
+
+        profile_anchor *Anchor = Thread->Anchors + AnchorIndex;
+        OldTSCElapsedInclusive = Anchor->TSCElapsedInclusive;
+        Anchor->ProcessedByteCount += ByteCount;
+        
+        ParentPathIndex = Thread->CurrentPath;
+        PathIndex = EnterProfilePath(Thread, AnchorIndex);
+        
+        Thread->ParentIndex = AnchorIndex;
+        Thread->CurrentPath = PathIndex;
+        StartTSC = READ_BLOCK_TIMER();
+    }
+    
+    ~profile_block(void)
+    {
+        u64 Elapsed = READ_BLOCK_TIMER() - StartTSC;
+        Thread->ParentIndex = ParentIndex;
+        Thread->CurrentPath = ParentPathIndex;
+        
+        if(PathIndex != ParentPathIndex)
+        {
+            profile_path_node *ParentPath = Thread->Paths + ParentPathIndex;
+            profile_path_node *Path = Thread->Paths + PathIndex;
+            
+            ParentPath->TSCElapsedExclusive -= Elapsed;
+            Path->TSCElapsedExclusive += Elapsed;
+            Path->TSCElapsedInclusive += Elapsed;
+            ++Path->HitCount;
+        }
+    
+        profile_anchor *Parent = Thread->Anchors + ParentIndex;
+        profile_anchor *Anchor = Thread->Anchors + AnchorIndex;
+        
+        Parent->TSCElapsedExclusive -= Elapsed;
+        Anchor->TSCElapsedExclusive += Elapsed;
+        Anchor->TSCElapsedInclusive = OldTSCElapsedInclusive + Elapsed;
+        ++Anchor->HitCount;
+        
+        /* NOTE(casey): This write happens every time solely because there is no
+           straightforward way in C++ to have the same ease-of-use. In a better programming
+           language, it would be simple to have the anchor points gathered and labeled at compile
+           time, and this repetative write would be eliminated. */
+        Anchor->Label = Label;
+    }
+    
+    profile_thread *Thread;
+    char const *Label;
+    u64 OldTSCElapsedInclusive;
+    u64 StartTSC;
+    u32 ParentIndex;
+    u32 AnchorIndex;
+    u32 ParentPathIndex;
+    u32 PathIndex;
+};
+
+#define NameConcat2(A, B) A##B
+#define NameConcat(A, B) NameConcat2(A, B)
+#define TimeBandwidth(Name, ByteCount) profile_block NameConcat(Block, __LINE__)(Name, __COUNTER__ + 1, ByteCount)
+#define TimeBlock(Name) TimeBandwidth(Name, 0)
+#define ProfilerEndOfCompilationUnit static_assert(__COUNTER__ < ArrayCount(GlobalProfilerThreads[0].Anchors), "Number of profile points exceeds size of profiler::Anchors array")
+
+static void PrintTimeElapsed(u64 TotalTSCElapsed, u64 TimerFreq, profile_anchor *Anchor)
+{
+    f64 Percent = 100.0 * ((f64)Anchor->TSCElapsedExclusive / (f64)TotalTSCElapsed);
+    printf("  %s[%llu]: %llu (%.2f%%", Anchor->Label, Anchor->HitCount, Anchor->TSCElapsedExclusive, Percent);
+    if(Anchor->TSCElapsedInclusive != Anchor->TSCElapsedExclusive)
+    {
+        f64 PercentWithChildren = 100.0 * ((f64)Anchor->TSCElapsedInclusive / (f64)TotalTSCElapsed);
+        printf(", %.2f%% w/children", PercentWithChildren);
+    }
+    printf(")");
+    
+    /* NOTE: Bandwidth is measured against the inclusive time, since the bytes are
+       processed by the block as a whole, including whatever it calls to do it. */
+    if(Anchor->ProcessedByteCount && TimerFreq)
+    {
+        f64 Megabyte = 1024.0*1024.0;
+        f64 Gigabyte = Megabyte*1024.0;
+        
+        f64 Seconds = (f64)Anchor->TSCElapsedInclusive / (f64)TimerFreq;
+        f64 BytesPerSecond = (f64)Anchor->ProcessedByteCount / Seconds;
+        f64 Megabytes = (f64)Anchor->ProcessedByteCount / Megabyte;
+        
+        printf("  %.3fmb at %.2fmb/s (%.2fgb/s)", Megabytes, BytesPerSecond / Megabyte, BytesPerSecond / Gigabyte);
+    }
+    printf("\n");
+}
+
+static void PrintPathTree(profile_thread *Thread, u32 PathIndex, u32 Depth, u64 TotalTSCElapsed)
+{
+    for(u32 ChildIndex = Thread->Paths[PathIndex].FirstChild;
+        ChildIndex;
+        ChildIndex = Thread->Paths[ChildIndex].NextSibling)
+    {
+        profile_path_node *Path = Thread->Paths + ChildIndex;
+        profile_anchor *Anchor = Thread->Anchors + Path->AnchorIndex;
+        
+        f64 Percent = 100.0 * ((f64)Path->TSCElapsedInclusive / (f64)TotalTSCElapsed);
+        f64 PercentSelf = 100.0 * ((f64)Path->TSCElapsedExclusive / (f64)TotalTSCElapsed);
+        printf("  %*s%s[%llu]: %.2f%%", 2*Depth, "", Anchor->Label, Path->HitCount, Percent);
+        if(Path->FirstChild)
+        {
+            printf(" (%.2f%% self)", PercentSelf);
+        }
+        printf("\n");
+        
+        PrintPathTree(Thread, ChildIndex, Depth + 1, TotalTSCElapsed);
+    }
+}
+
+static void PrintCallTrees(u32 ThreadCount, u64 TotalTSCElapsed)
+{
+    for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profile_thread *Thread = GlobalProfilerThreads + ThreadIndex;
+        
+        printf("\nCall tree");
+        if(ThreadCount > 1)
+        {
+            printf(" (thread %u)", ThreadIndex);
+        }
+        printf(":\n");
+        
+        PrintPathTree(Thread, 0, 0, TotalTSCElapsed);
+        
+        if(Thread->PathsOverflowed)
+        {
+            printf("  WARNING: More than %u call paths, some blocks are missing from this tree.\n", MAX_PROFILER_PATHS);
+        }
+    }
+}
+
+/* NOTE: The collapsed stack format is one line per call path, with the labels from the root
+   down separated by semicolons, followed by a count. Flamegraph tools (flamegraph.pl,
+   speedscope, inferno, ...) read it directly. The count here is the exclusive time of the
+   path in timer ticks, so the width of every frame in the graph is its inclusive time. */
+static void WriteCollapsedPath(FILE *Out, profile_thread *Thread, u32 PathIndex,
+                               char *Stack, u32 StackLength, u32 StackCapacity)
+{
+    for(u32 ChildIndex = Thread->Paths[PathIndex].FirstChild;
+        ChildIndex;
+        ChildIndex = Thread->Paths[ChildIndex].NextSibling)
+    {
+        profile_path_node *Path = Thread->Paths + ChildIndex;
+        char const *Label = Thread->Anchors[Path->AnchorIndex].Label;
+        
+        int Written = snprintf(Stack + StackLength, StackCapacity - StackLength, "%s%s",
+                               StackLength ? ";" : "", Label);
+        u32 ChildLength = StackLength + (u32)Written;
+        if((Written < 0) || (ChildLength >= StackCapacity))
+        {
+            continue;
+        }
+        
+        if(Path->TSCElapsedExclusive)
+        {
+            fprintf(Out, "%s %llu\n", Stack, Path->TSCElapsedExclusive);
+        }
+        
+        WriteCollapsedPath(Out, Thread, ChildIndex, Stack, ChildLength, StackCapacity);
+        Stack[StackLength] = 0;
+    }
+}
+
+static void WriteCollapsedStacks(char const *FileName, u32 ThreadCount)
+{
+    FILE *Out = fopen(FileName, "wb");
+    if(Out)
+    {
+        for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+        {
+            char Stack[4096];
+            u32 StackLength = 0;
+            if(ThreadCount > 1)
+            {
+                StackLength = (u32)snprintf(Stack, sizeof(Stack), "Thread %u", ThreadIndex);
+            }
+            Stack[StackLength] = 0;
+            
+            WriteCollapsedPath(Out, GlobalProfilerThreads + ThreadIndex, 0, Stack, StackLength, sizeof(Stack));
+        }
+        
+        fclose(Out);
+        printf("\nCollapsed stacks written to %s\n", FileName);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open \"%s\" for writing.\n", FileName);
+    }
+}
+
+static void PrintAnchorData(u64 TotalTSCElapsed, u64 TimerFreq)
+{
+    u32 ThreadCount = GlobalProfilerThreadCount;
+    if(ThreadCount > MAX_PROFILER_THREADS)
+    {
+        printf("WARNING: %u threads were profiled, but there are only tables for %u. The last table is unreliable.\n",
+               ThreadCount, MAX_PROFILER_THREADS);
+        ThreadCount = MAX_PROFILER_THREADS;
+    }
+    
+    /* NOTE: Anchors are identified by the same index on every thread, so merging is just
+       summing the tables. A time in the merged table is the sum over all threads, which
+       means its percentage of the total wall time can be above 100% when threads overlap. */
+    static profile_anchor Merged[ArrayCount(GlobalProfilerThreads[0].Anchors)];
+    for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profile_thread *Thread = GlobalProfilerThreads + ThreadIndex;
+        
+        if(ThreadCount > 1)
+        {
+            printf("\nThread %u:\n", ThreadIndex);
+        }
+        
+        for(u32 AnchorIndex = 0; AnchorIndex < ArrayCount(Thread->Anchors); ++AnchorIndex)
+        {
+            profile_anchor *Anchor = Thread->Anchors + AnchorIndex;
+            if(Anchor->TSCElapsedInclusive)
+            {
+                PrintTimeElapsed(TotalTSCElapsed, TimerFreq, Anchor);
+                
+                profile_anchor *Sum = Merged + AnchorIndex;
+                Sum->TSCElapsedExclusive += Anchor->TSCElapsedExclusive;
+                Sum->TSCElapsedInclusive += Anchor->TSCElapsedInclusive;
+                Sum->HitCount += Anchor->HitCount;
+                Sum->ProcessedByteCount += Anchor->ProcessedByteCount;
+                Sum->Label = Anchor->Label;
+            }
+        }
+    }
+    
+    if(ThreadCount > 1)
+    {
+        printf("\nAll threads (summed, percentages of wall time):\n");
+        for(u32 AnchorIndex = 0; AnchorIndex < ArrayCount(Merged); ++AnchorIndex)
+        {
+            profile_anchor *Anchor = Merged + AnchorIndex;
+            if(Anchor->TSCElapsedInclusive)
+            {
+                PrintTimeElapsed(TotalTSCElapsed, TimerFreq, Anchor);
+            }
+        }
+    }
+    
+    PrintCallTrees(ThreadCount, TotalTSCElapsed);
+    
+#ifdef PROFILER_COLLAPSED_STACKS_FILE
+    WriteCollapsedStacks(PROFILER_COLLAPSED_STACKS_FILE, ThreadCount);
+#endif
+}
+
+#else
+
+#define TimeBlock(...)
+#define TimeBandwidth(...)
+#define PrintAnchorData(...)
+#define ProfilerEndOfCompilationUnit
+
+#endif
+
+struct profiler
+{
+    u64 StartTSC;
+    u64 EndTSC;
+};
+static profiler GlobalProfiler;
+
+#define TimeFunction TimeBlock(__func__)
+
+static u64 EstimateBlockTimerFreq(void)
+{
+    (void)&EstimateCPUTimerFreq; // NOTE(casey): This has to be voided here to prevent compilers from warning us that it is not used
+    
+	u64 MillisecondsToWait = 100;
+	u64 OSFreq = GetOSTimerFreq();
+
+	u64 BlockStart = READ_BLOCK_TIMER();
+	u64 OSStart = ReadOSTimer();
+	u64 OSEnd = 0;
+	u64 OSElapsed = 0;
+	u64 OSWaitTime = OSFreq * MillisecondsToWait / 1000;
+	while(OSElapsed < OSWaitTime)
+	{
+		OSEnd = ReadOSTimer();
+		OSElapsed = OSEnd - OSStart;
+	}
+	
+	u64 BlockEnd = READ_BLOCK_TIMER();
+	u64 BlockElapsed = BlockEnd - BlockStart;
+	
+	u64 BlockFreq = 0;
+	if(OSElapsed)
+	{
+		BlockFreq = OSFreq * BlockElapsed / OSElapsed;
+	}
+	
+	return BlockFreq;
+}
+
+static void BeginProfile(void)
+{
+    GlobalProfiler.StartTSC = READ_BLOCK_TIMER();
+}
+
+/* NOTE: All threads that were profiled have to be finished (joined) before this is called,
+   otherwise their tables are read while they are still being written. */
+static void EndAndPrintProfile()
+{
+    GlobalProfiler.EndTSC = READ_BLOCK_TIMER();
+    u64 TimerFreq = EstimateBlockTimerFreq();
+    
+    u64 TotalTSCElapsed = GlobalProfiler.EndTSC - GlobalProfiler.StartTSC;
+    
+    if(TimerFreq)
+    {
+        printf("\nTotal time: %0.4fms (timer freq %llu)\n", 1000.0 * (f64)TotalTSCElapsed / (f64)TimerFreq, TimerFreq);
+    }
+    
+    PrintAnchorData(TotalTSCElapsed, TimerFreq);
+}
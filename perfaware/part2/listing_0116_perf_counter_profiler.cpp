@@ -0,0 +1,1104 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 116
+   ======================================================================== */
+
+#include "listing_0074_platform_metrics.cpp"
+
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+#ifndef READ_BLOCK_TIMER
+#define READ_BLOCK_TIMER ReadCPUTimer
+#endif
+
+#ifndef MAX_PROFILER_THREADS
+#define MAX_PROFILER_THREADS 64
+#endif
+
+#ifndef MAX_PROFILER_ANCHORS
+#define MAX_PROFILER_ANCHORS 4096
+#endif
+
+#ifndef MAX_PROFILER_PATHS
+#define MAX_PROFILER_PATHS 4096
+#endif
+
+/* NOTE: With PROFILER_SUBTRACT_OVERHEAD, the estimated cost of the profiler itself (see
+   MeasureProfilerOverhead) is taken out of every exclusive and inclusive time before they
+   are printed. The estimate is always printed either way. */
+#ifndef PROFILER_SUBTRACT_OVERHEAD
+#define PROFILER_SUBTRACT_OVERHEAD 0
+#endif
+
+/* NOTE: PROFILER_PERF_COUNTERS 1 (Linux only) additionally reads the hardware performance
+   counters below around every block, so the report can say why a block is slow and not just
+   that it is. The counters are opened per thread with perf_event_open and, where the kernel
+   allows it, read in user mode with rdpmc. */
+#ifndef PROFILER_PERF_COUNTERS
+#define PROFILER_PERF_COUNTERS 0
+#endif
+
+#if PROFILER_PERF_COUNTERS && !defined(__linux__)
+#error PROFILER_PERF_COUNTERS is only supported on Linux
+#endif
+
+/* NOTE: Defining PROFILER_TIMELINE_FILE turns on the timeline recorder. Every block then
+   also logs its start and end timestamps into a per-thread ring buffer, which is written
+   out as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev, speedscope) by
+   EndAndPrintProfile. When it is not defined, none of the recording code exists. */
+#ifndef PROFILER_TIMELINE_EVENTS
+#define PROFILER_TIMELINE_EVENTS (1 << 16) // NOTE: Must be a power of two
+#endif
+
+#if PROFILER
+
+#include <atomic>
+
+#if PROFILER_PERF_COUNTERS
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+enum profile_counter
+{
+    ProfileCounter_Cycles,
+    ProfileCounter_Instructions,
+    ProfileCounter_CacheMisses,
+    ProfileCounter_BranchMisses,
+    
+    ProfileCounter_Count,
+};
+#endif
+
+struct profile_anchor
+{
+    u64 TSCElapsedExclusive; // NOTE: Does NOT include children
+    u64 TSCElapsedInclusive; // NOTE: DOES include children
+    u64 HitCount;
+    u64 ProcessedByteCount;
+#if PROFILER_PERF_COUNTERS
+    u64 CountersExclusive[ProfileCounter_Count];
+    u64 CountersInclusive[ProfileCounter_Count];
+#endif
+};
+
+/* NOTE: An anchor sums up everything that happened at one TimeBlock, no matter where it was
+   called from. To be able to print a call tree, each thread additionally keeps one path node
+   per distinct chain of blocks that led to a block. Path node 0 is the root. Children of a
+   node are kept in a singly linked list in the order they were first entered, and since a
+   block usually has very few distinct children, finding the right one on entry is a short
+   walk. A recursive call gets a new, deeper node, so a node can never be its own ancestor
+   and its inclusive time can simply be summed. */
+struct profile_path_node
+{
+    u64 TSCElapsedExclusive;
+    u64 TSCElapsedInclusive;
+    u64 HitCount;
+    u32 AnchorIndex;
+    u32 FirstChild;
+    u32 LastChild;
+    u32 NextSibling;
+};
+
+#ifdef PROFILER_TIMELINE_FILE
+static_assert((PROFILER_TIMELINE_EVENTS & (PROFILER_TIMELINE_EVENTS - 1)) == 0, "PROFILER_TIMELINE_EVENTS must be a power of two");
+
+/* NOTE: An event is written once, when the block ends, so that recording costs a single
+   24-byte store instead of a begin and an end record. The ring keeps the most recent
+   PROFILER_TIMELINE_EVENTS blocks of each thread; anything older is overwritten. */
+struct profile_timeline_event
+{
+    u64 StartTSC;
+    u64 EndTSC;
+    u32 AnchorIndex;
+    u32 Depth;
+};
+#endif
+
+#if PROFILER_PERF_COUNTERS
+/* NOTE: perf_event_open counters only count the thread that opened them, so every thread
+   opens its own group. Page points at the mmapped control page of each counter, which
+   tells whether rdpmc is allowed and which hardware counter to read. If rdpmc is not
+   allowed (or the counter cannot be mmapped), the whole group is read with one read()
+   on the group leader instead, which works but costs a syscall per block. */
+struct profile_perf_counters
+{
+    int Fds[ProfileCounter_Count];
+    perf_event_mmap_page *Pages[ProfileCounter_Count];
+    b32 IsOpen;
+    b32 UseRDPMC;
+    int OpenError;
+};
+#endif
+
+/* NOTE: Every thread that enters a profile block gets its own anchor table and its own
+   parent index, so blocks on different threads never touch the same counters and the
+   parent chain of one thread cannot be broken by another. The tables live in a global
+   array rather than in thread_local storage so that they are still around when the
+   threads have exited and EndAndPrintProfile merges them. */
+struct profile_thread
+{
+    profile_anchor Anchors[MAX_PROFILER_ANCHORS];
+    u32 ParentIndex;
+    
+    profile_path_node Paths[MAX_PROFILER_PATHS];
+    u32 PathCount;
+    u32 CurrentPath;
+    b32 PathsOverflowed;
+    
+#ifdef PROFILER_TIMELINE_FILE
+    /* NOTE: The ring is allocated the first time a thread enters a block, so that the
+       global thread array does not carry MAX_PROFILER_THREADS rings that are never used. */
+    profile_timeline_event *Timeline;
+    u64 TimelineEventCount;
+    u32 Depth;
+#endif
+    
+#if PROFILER_PERF_COUNTERS
+    profile_perf_counters PerfCounters;
+#endif
+};
+
+/* NOTE: Anchor indices are no longer handed out by __COUNTER__, which restarts in every
+   translation unit. Instead, every TimeBlock site has a function-local static that asks
+   RegisterProfileAnchor for an index the first time the block is entered, and the label is
+   stored exactly once, in AnchorLabels, at that point. All of this state, and the thread
+   tables, live in one object returned by an inline function, so every .cpp file that
+   includes the profiler shares it. (An inline function rather than an inline variable,
+   because the latter needs C++17 and cl still defaults to C++14.) Because the object has
+   no constructor, it is zero-initialized at load time and there is no init guard to check. */
+struct profiler_globals
+{
+    profile_thread Threads[MAX_PROFILER_THREADS];
+    std::atomic<u32> ThreadCount;
+    
+    std::atomic<u32> AnchorCount;
+    char const *AnchorLabels[MAX_PROFILER_ANCHORS];
+    
+    // NOTE: Timer ticks per block, as measured by MeasureProfilerOverhead
+    f64 OverheadInsideBlock;
+    f64 OverheadOutsideBlock;
+};
+
+inline profiler_globals *GetProfilerGlobals(void)
+{
+    static profiler_globals Globals;
+    return &Globals;
+}
+
+/* NOTE: Anchor 0 is the "no parent" anchor and the last anchor collects every site that
+   did not fit, so that running out of anchors skews the numbers instead of crashing. */
+inline u32 RegisterProfileAnchor(char const *Label)
+{
+    profiler_globals *Globals = GetProfilerGlobals();
+    
+    u32 AnchorIndex = ++Globals->AnchorCount;
+    if(AnchorIndex >= (MAX_PROFILER_ANCHORS - 1))
+    {
+        AnchorIndex = MAX_PROFILER_ANCHORS - 1;
+        Label = "(anchors exhausted)";
+    }
+    Globals->AnchorLabels[AnchorIndex] = Label;
+    
+    return AnchorIndex;
+}
+
+static char const *GetAnchorLabel(u32 AnchorIndex)
+{
+    char const *Result = GetProfilerGlobals()->AnchorLabels[AnchorIndex];
+    return Result;
+}
+
+static u32 EnterProfilePath(profile_thread *Thread, u32 AnchorIndex)
+{
+    profile_path_node *Parent = Thread->Paths + Thread->CurrentPath;
+    
+    u32 Result = Parent->FirstChild;
+    while(Result && (Thread->Paths[Result].AnchorIndex != AnchorIndex))
+    {
+        Result = Thread->Paths[Result].NextSibling;
+    }
+    
+    if(!Result)
+    {
+        if(Thread->PathCount == 0)
+        {
+            // NOTE: Node 0 is the root, so the first real node is 1.
+            Thread->PathCount = 1;
+        }
+        
+        if(Thread->PathCount < MAX_PROFILER_PATHS)
+        {
+            Result = Thread->PathCount++;
+            profile_path_node *Node = Thread->Paths + Result;
+            Node->AnchorIndex = AnchorIndex;
+            
+            if(Parent->LastChild)
+            {
+                Thread->Paths[Parent->LastChild].NextSibling = Result;
+            }
+            else
+            {
+                Parent->FirstChild = Result;
+            }
+            Parent->LastChild = Result;
+        }
+        else
+        {
+            /* NOTE: When the table is full, the block stays on its parent's node and is
+               simply missing from the tree. The flat anchor data is still complete. */
+            Thread->PathsOverflowed = true;
+            Result = Thread->CurrentPath;
+        }
+    }
+    
+    return Result;
+}
+
+#if PROFILER_PERF_COUNTERS
+static void OpenPerfCounters(profile_perf_counters *Counters)
+{
+    static u64 const Configs[ProfileCounter_Count] =
+    {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    
+    Counters->UseRDPMC = true;
+    
+    int GroupFd = -1;
+    u32 OpenCount = 0;
+    for(; OpenCount < ProfileCounter_Count; ++OpenCount)
+    {
+        perf_event_attr Attr = {};
+        Attr.size = sizeof(Attr);
+        Attr.type = PERF_TYPE_HARDWARE;
+        Attr.config = Configs[OpenCount];
+        Attr.read_format = PERF_FORMAT_GROUP;
+        Attr.exclude_kernel = 1;
+        Attr.exclude_hv = 1;
+        
+        int Fd = (int)syscall(SYS_perf_event_open, &Attr, 0, -1, GroupFd, 0);
+        if(Fd < 0)
+        {
+            Counters->OpenError = errno;
+            break;
+        }
+        
+        if(GroupFd < 0)
+        {
+            GroupFd = Fd;
+        }
+        Counters->Fds[OpenCount] = Fd;
+        
+        void *Page = mmap(0, (size_t)sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, Fd, 0);
+        if(Page == MAP_FAILED)
+        {
+            Page = 0;
+            Counters->UseRDPMC = false;
+        }
+        else if(!((perf_event_mmap_page *)Page)->cap_user_rdpmc)
+        {
+            Counters->UseRDPMC = false;
+        }
+        Counters->Pages[OpenCount] = (perf_event_mmap_page *)Page;
+    }
+    
+    if(OpenCount == ProfileCounter_Count)
+    {
+        Counters->IsOpen = true;
+    }
+    else
+    {
+        for(u32 CounterIndex = 0; CounterIndex < OpenCount; ++CounterIndex)
+        {
+            if(Counters->Pages[CounterIndex])
+            {
+                munmap(Counters->Pages[CounterIndex], (size_t)sysconf(_SC_PAGESIZE));
+            }
+            close(Counters->Fds[CounterIndex]);
+        }
+        Counters->UseRDPMC = false;
+    }
+}
+
+/* NOTE: This is the read sequence documented in linux/perf_event.h. The kernel bumps lock
+   whenever it changes index or offset (e.g. when the thread migrates), in which case the
+   read is simply repeated. index is 0 while the counter is not scheduled on the hardware. */
+inline u64 ReadPerfCounterRDPMC(perf_event_mmap_page *Page)
+{
+    u64 Result;
+    u32 Sequence;
+    do
+    {
+        Sequence = Page->lock;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        
+        u32 Index = Page->index;
+        Result = (u64)Page->offset;
+        if(Index)
+        {
+            u32 Shift = 64 - Page->pmc_width;
+            u64 Raw = __rdpmc((int)(Index - 1));
+            Result += (u64)(((int64_t)(Raw << Shift)) >> Shift);
+        }
+        
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    } while(Page->lock != Sequence);
+    
+    return Result;
+}
+
+inline void ReadPerfCounters(profile_thread *Thread, u64 *Values)
+{
+    profile_perf_counters *Counters = &Thread->PerfCounters;
+    if(Counters->UseRDPMC)
+    {
+        for(u32 CounterIndex = 0; CounterIndex < ProfileCounter_Count; ++CounterIndex)
+        {
+            Values[CounterIndex] = ReadPerfCounterRDPMC(Counters->Pages[CounterIndex]);
+        }
+    }
+    else if(Counters->IsOpen)
+    {
+        // NOTE: PERF_FORMAT_GROUP reads as the number of counters followed by their values.
+        // A failed or short read reports zero rather than leaving the caller's values unwritten.
+        u64 Group[1 + ProfileCounter_Count] = {};
+        if(read(Counters->Fds[0], Group, sizeof(Group)) == (ssize_t)sizeof(Group))
+        {
+            memcpy(Values, Group + 1, sizeof(u64)*ProfileCounter_Count);
+        }
+        else
+        {
+            memset(Values, 0, sizeof(u64)*ProfileCounter_Count);
+        }
+    }
+    else
+    {
+        memset(Values, 0, sizeof(u64)*ProfileCounter_Count);
+    }
+}
+#endif
+
+/* NOTE: This is inline (not static) so that the thread_local below is one variable for the
+   whole program, otherwise a thread would get a second table in each translation unit. */
+inline profile_thread *GetProfilerThread(void)
+{
+    static thread_local profile_thread *ThreadTable;
+    
+    profile_thread *Result = ThreadTable;
+    if(!Result)
+    {
+        profiler_globals *Globals = GetProfilerGlobals();
+        
+        /* NOTE: If there are more threads than tables, the extra threads share the last
+           table. Their numbers will be garbage, but EndAndPrintProfile warns about it. */
+        u32 ThreadIndex = Globals->ThreadCount++;
+        if(ThreadIndex >= MAX_PROFILER_THREADS)
+        {
+            ThreadIndex = MAX_PROFILER_THREADS - 1;
+        }
+        
+        Result = Globals->Threads + ThreadIndex;
+        ThreadTable = Result;
+        
+#ifdef PROFILER_TIMELINE_FILE
+        if(!Result->Timeline)
+        {
+            Result->Timeline = (profile_timeline_event *)calloc(PROFILER_TIMELINE_EVENTS, sizeof(profile_timeline_event));
+        }
+#endif
+        
+#if PROFILER_PERF_COUNTERS
+        if(!Result->PerfCounters.IsOpen)
+        {
+            OpenPerfCounters(&Result->PerfCounters);
+        }
+#endif
+    }
+    
+    return Result;
+}
+
+struct profile_block
+{
+    profile_block(u32 AnchorIndex_, u64 ByteCount)
+    {
+        Thread = GetProfilerThread();
+        ParentIndex = Thread->ParentIndex;
+        
+        AnchorIndex = AnchorIndex_;
+
+        profile_anchor *Anchor = Thread->Anchors + AnchorIndex;
+        OldTSCElapsedInclusive = Anchor->TSCElapsedInclusive;
+        Anchor->ProcessedByteCount += ByteCount;
+        
+        ParentPathIndex = Thread->CurrentPath;
+        PathIndex = EnterProfilePath(Thread, AnchorIndex);
+        
+        Thread->ParentIndex = AnchorIndex;
+        Thread->CurrentPath = PathIndex;
+#ifdef PROFILER_TIMELINE_FILE
+        ++Thread->Depth;
+#endif
+#if PROFILER_PERF_COUNTERS
+        for(u32 CounterIndex = 0; CounterIndex < ProfileCounter_Count; ++CounterIndex)
+        {
+            OldCountersInclusive[CounterIndex] = Anchor->CountersInclusive[CounterIndex];
+        }
+        ReadPerfCounters(Thread, StartCounters);
+#endif
+        StartTSC = READ_BLOCK_TIMER();
+    }
+    
+    ~profile_block(void)
+    {
+        u64 EndTSC = READ_BLOCK_TIMER();
+        u64 Elapsed = EndTSC - StartTSC;
+#if PROFILER_PERF_COUNTERS
+        u64 EndCounters[ProfileCounter_Count];
+        ReadPerfCounters(Thread, EndCounters);
+#endif
+        Thread->ParentIndex = ParentIndex;
+        Thread->CurrentPath = ParentPathIndex;
+        
+#ifdef PROFILER_TIMELINE_FILE
+        u32 Depth = --Thread->Depth;
+        if(Thread->Timeline)
+        {
+            profile_timeline_event *Event = Thread->Timeline + (Thread->TimelineEventCount++ & (PROFILER_TIMELINE_EVENTS - 1));
+            Event->StartTSC = StartTSC;
+            Event->EndTSC = EndTSC;
+            Event->AnchorIndex = AnchorIndex;
+            Event->Depth = Depth;
+        }
+#endif
+        
+        if(PathIndex != ParentPathIndex)
+        {
+            profile_path_node *ParentPath = Thread->Paths + ParentPathIndex;
+            profile_path_node *Path = Thread->Paths + PathIndex;
+            
+            ParentPath->TSCElapsedExclusive -= Elapsed;
+            Path->TSCElapsedExclusive += Elapsed;
+            Path->TSCElapsedInclusive += Elapsed;
+            ++Path->HitCount;
+        }
+    
+        profile_anchor *Parent = Thread->Anchors + ParentIndex;
+        profile_anchor *Anchor = Thread->Anchors + AnchorIndex;
+        
+        Parent->TSCElapsedExclusive -= Elapsed;
+        Anchor->TSCElapsedExclusive += Elapsed;
+        Anchor->TSCElapsedInclusive = OldTSCElapsedInclusive + Elapsed;
+        ++Anchor->HitCount;
+        
+#if PROFILER_PERF_COUNTERS
+        for(u32 CounterIndex = 0; CounterIndex < ProfileCounter_Count; ++CounterIndex)
+        {
+            u64 Counted = EndCounters[CounterIndex] - StartCounters[CounterIndex];
+            Parent->CountersExclusive[CounterIndex] -= Counted;
+            Anchor->CountersExclusive[CounterIndex] += Counted;
+            Anchor->CountersInclusive[CounterIndex] = OldCountersInclusive[CounterIndex] + Counted;
+        }
+#endif
+    }
+    
+    profile_thread *Thread;
+    u64 OldTSCElapsedInclusive;
+    u64 StartTSC;
+#if PROFILER_PERF_COUNTERS
+    u64 OldCountersInclusive[ProfileCounter_Count];
+    u64 StartCounters[ProfileCounter_Count];
+#endif
+    u32 ParentIndex;
+    u32 AnchorIndex;
+    u32 ParentPathIndex;
+    u32 PathIndex;
+};
+
+#define NameConcat2(A, B) A##B
+#define NameConcat(A, B) NameConcat2(A, B)
+#define TimeBandwidth(Name, ByteCount) \
+    static u32 const NameConcat(Anchor, __LINE__) = RegisterProfileAnchor(Name); \
+    profile_block NameConcat(Block, __LINE__)(NameConcat(Anchor, __LINE__), ByteCount)
+#define TimeBlock(Name) TimeBandwidth(Name, 0)
+
+// NOTE: No longer needed, since anchors are not counted per translation unit. Kept so that existing code still compiles.
+#define ProfilerEndOfCompilationUnit
+
+static void PrintTimeElapsed(u64 TotalTSCElapsed, u64 TimerFreq, char const *Label, profile_anchor *Anchor)
+{
+    f64 Percent = 100.0 * ((f64)Anchor->TSCElapsedExclusive / (f64)TotalTSCElapsed);
+    printf("  %s[%llu]: %llu (%.2f%%", Label, Anchor->HitCount, Anchor->TSCElapsedExclusive, Percent);
+    if(Anchor->TSCElapsedInclusive != Anchor->TSCElapsedExclusive)
+    {
+        f64 PercentWithChildren = 100.0 * ((f64)Anchor->TSCElapsedInclusive / (f64)TotalTSCElapsed);
+        printf(", %.2f%% w/children", PercentWithChildren);
+    }
+    printf(")");
+    
+    /* NOTE: Bandwidth is measured against the inclusive time, since the bytes are
+       processed by the block as a whole, including whatever it calls to do it. */
+    if(Anchor->ProcessedByteCount && TimerFreq)
+    {
+        f64 Megabyte = 1024.0*1024.0;
+        f64 Gigabyte = Megabyte*1024.0;
+        
+        f64 Seconds = (f64)Anchor->TSCElapsedInclusive / (f64)TimerFreq;
+        f64 BytesPerSecond = (f64)Anchor->ProcessedByteCount / Seconds;
+        f64 Megabytes = (f64)Anchor->ProcessedByteCount / Megabyte;
+        
+        printf("  %.3fmb at %.2fmb/s (%.2fgb/s)", Megabytes, BytesPerSecond / Megabyte, BytesPerSecond / Gigabyte);
+    }
+    printf("\n");
+    
+#if PROFILER_PERF_COUNTERS
+    /* NOTE: Counters are reported for the exclusive part of the block, since that is the
+       code the block itself runs. The counts include the profiler's own instructions, which
+       matters for blocks that are very short. */
+    u64 *Counters = Anchor->CountersExclusive;
+    if(Counters[ProfileCounter_Cycles])
+    {
+        f64 Instructions = (f64)Counters[ProfileCounter_Instructions];
+        f64 KiloInstructions = (Instructions > 0) ? (Instructions / 1000.0) : 1.0;
+        printf("      %.2f IPC (%llu instructions in %llu cycles), %llu cache misses (%.2f per 1k instructions), %llu branch misses (%.2f per 1k instructions)\n",
+               Instructions / (f64)Counters[ProfileCounter_Cycles],
+               Counters[ProfileCounter_Instructions], Counters[ProfileCounter_Cycles],
+               Counters[ProfileCounter_CacheMisses], (f64)Counters[ProfileCounter_CacheMisses] / KiloInstructions,
+               Counters[ProfileCounter_BranchMisses], (f64)Counters[ProfileCounter_BranchMisses] / KiloInstructions);
+    }
+#endif
+}
+
+static void PrintPathTree(profile_thread *Thread, u32 PathIndex, u32 Depth, u64 TotalTSCElapsed)
+{
+    for(u32 ChildIndex = Thread->Paths[PathIndex].FirstChild;
+        ChildIndex;
+        ChildIndex = Thread->Paths[ChildIndex].NextSibling)
+    {
+        profile_path_node *Path = Thread->Paths + ChildIndex;
+        
+        f64 Percent = 100.0 * ((f64)Path->TSCElapsedInclusive / (f64)TotalTSCElapsed);
+        f64 PercentSelf = 100.0 * ((f64)Path->TSCElapsedExclusive / (f64)TotalTSCElapsed);
+        printf("  %*s%s[%llu]: %.2f%%", 2*Depth, "", GetAnchorLabel(Path->AnchorIndex), Path->HitCount, Percent);
+        if(Path->FirstChild)
+        {
+            printf(" (%.2f%% self)", PercentSelf);
+        }
+        printf("\n");
+        
+        PrintPathTree(Thread, ChildIndex, Depth + 1, TotalTSCElapsed);
+    }
+}
+
+static void PrintCallTrees(u32 ThreadCount, u64 TotalTSCElapsed)
+{
+    for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profile_thread *Thread = GetProfilerGlobals()->Threads + ThreadIndex;
+        
+        printf("\nCall tree");
+        if(ThreadCount > 1)
+        {
+            printf(" (thread %u)", ThreadIndex);
+        }
+        printf(":\n");
+        
+        PrintPathTree(Thread, 0, 0, TotalTSCElapsed);
+        
+        if(Thread->PathsOverflowed)
+        {
+            printf("  WARNING: More than %u call paths, some blocks are missing from this tree.\n", MAX_PROFILER_PATHS);
+        }
+    }
+}
+
+#ifdef PROFILER_COLLAPSED_STACKS_FILE
+/* NOTE: The collapsed stack format is one line per call path, with the labels from the root
+   down separated by semicolons, followed by a count. Flamegraph tools (flamegraph.pl,
+   speedscope, inferno, ...) read it directly. The count here is the exclusive time of the
+   path in timer ticks, so the width of every frame in the graph is its inclusive time. */
+static void WriteCollapsedPath(FILE *Out, profile_thread *Thread, u32 PathIndex,
+                               char *Stack, u32 StackLength, u32 StackCapacity)
+{
+    for(u32 ChildIndex = Thread->Paths[PathIndex].FirstChild;
+        ChildIndex;
+        ChildIndex = Thread->Paths[ChildIndex].NextSibling)
+    {
+        profile_path_node *Path = Thread->Paths + ChildIndex;
+        char const *Label = GetAnchorLabel(Path->AnchorIndex);
+        
+        int Written = snprintf(Stack + StackLength, StackCapacity - StackLength, "%s%s",
+                               StackLength ? ";" : "", Label);
+        u32 ChildLength = StackLength + (u32)Written;
+        if((Written < 0) || (ChildLength >= StackCapacity))
+        {
+            continue;
+        }
+        
+        if(Path->TSCElapsedExclusive)
+        {
+            fprintf(Out, "%s %llu\n", Stack, Path->TSCElapsedExclusive);
+        }
+        
+        WriteCollapsedPath(Out, Thread, ChildIndex, Stack, ChildLength, StackCapacity);
+        Stack[StackLength] = 0;
+    }
+}
+
+static void WriteCollapsedStacks(char const *FileName, u32 ThreadCount)
+{
+    FILE *Out = fopen(FileName, "wb");
+    if(Out)
+    {
+        for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+        {
+            char Stack[4096];
+            u32 StackLength = 0;
+            if(ThreadCount > 1)
+            {
+                StackLength = (u32)snprintf(Stack, sizeof(Stack), "Thread %u", ThreadIndex);
+            }
+            Stack[StackLength] = 0;
+            
+            WriteCollapsedPath(Out, GetProfilerGlobals()->Threads + ThreadIndex, 0, Stack, StackLength, sizeof(Stack));
+        }
+        
+        fclose(Out);
+        printf("\nCollapsed stacks written to %s\n", FileName);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open \"%s\" for writing.\n", FileName);
+    }
+}
+#endif
+
+#ifdef PROFILER_TIMELINE_FILE
+static void WriteJSONString(FILE *Out, char const *String)
+{
+    fputc('"', Out);
+    for(char const *At = String; *At; ++At)
+    {
+        unsigned char C = (unsigned char)*At;
+        if((C == '"') || (C == '\\'))
+        {
+            fputc('\\', Out);
+            fputc(C, Out);
+        }
+        else if(C < 0x20)
+        {
+            fprintf(Out, "\\u%04x", C);
+        }
+        else
+        {
+            fputc(C, Out);
+        }
+    }
+    fputc('"', Out);
+}
+
+/* NOTE: Timestamps are written in microseconds relative to BeginProfile, which is what the
+   trace-event format expects. Events of one thread end up in the file in the order the
+   blocks ended, not the order they started; the viewers sort them on load. */
+static void WriteTimeline(char const *FileName, u64 ProfileStartTSC, u64 TimerFreq)
+{
+    FILE *Out = fopen(FileName, "wb");
+    if(!Out)
+    {
+        fprintf(stderr, "ERROR: Unable to open \"%s\" for writing.\n", FileName);
+        return;
+    }
+    
+    u32 ThreadCount = GetProfilerGlobals()->ThreadCount;
+    if(ThreadCount > MAX_PROFILER_THREADS)
+    {
+        ThreadCount = MAX_PROFILER_THREADS;
+    }
+    
+    f64 MicrosecondsPerTick = TimerFreq ? (1000000.0 / (f64)TimerFreq) : 1.0;
+    u64 DroppedEventCount = 0;
+    
+    fprintf(Out, "{\"traceEvents\":[\n");
+    char const *Separator = "";
+    for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profile_thread *Thread = GetProfilerGlobals()->Threads + ThreadIndex;
+        
+        fprintf(Out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}",
+                Separator, ThreadIndex, ThreadIndex);
+        Separator = ",\n";
+        
+        if(Thread->Timeline)
+        {
+            u64 EventCount = Thread->TimelineEventCount;
+            u64 FirstEvent = 0;
+            if(EventCount > PROFILER_TIMELINE_EVENTS)
+            {
+                FirstEvent = EventCount - PROFILER_TIMELINE_EVENTS;
+                DroppedEventCount += FirstEvent;
+            }
+            
+            for(u64 EventIndex = FirstEvent; EventIndex < EventCount; ++EventIndex)
+            {
+                profile_timeline_event *Event = Thread->Timeline + (EventIndex & (PROFILER_TIMELINE_EVENTS - 1));
+                
+                f64 Start = (f64)(Event->StartTSC - ProfileStartTSC) * MicrosecondsPerTick;
+                f64 Duration = (f64)(Event->EndTSC - Event->StartTSC) * MicrosecondsPerTick;
+                
+                fprintf(Out, "%s{\"name\":", Separator);
+                WriteJSONString(Out, GetAnchorLabel(Event->AnchorIndex));
+                fprintf(Out, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%u}}",
+                        ThreadIndex, Start, Duration, Event->Depth);
+            }
+        }
+    }
+    fprintf(Out, "\n],\"displayTimeUnit\":\"ns\"}\n");
+    fclose(Out);
+    
+    printf("\nTimeline written to %s\n", FileName);
+    if(DroppedEventCount)
+    {
+        printf("  WARNING: %llu older events were overwritten, raise PROFILER_TIMELINE_EVENTS to keep them.\n", DroppedEventCount);
+    }
+}
+#endif
+
+/* NOTE: Every block costs some time that ends up in the profile:
+     - inside the block, between the two timer reads: at least the latency of one read.
+       This is counted in the block's own exclusive and inclusive time.
+     - outside the block, from entering the constructor to the first timer read and from
+       the second timer read to leaving the destructor. Nobody measures this, so it lands
+       in the exclusive time of whatever block is the parent.
+   Both are measured by timing a batch of empty blocks from the outside and comparing that
+   to what the blocks measured themselves. The minimum over several batches is used, as the
+   others are only slower because of interrupts and cache misses.
+   This runs real blocks on the calling thread's table, so the table is saved first and
+   restored afterwards, and the timeline (if any) is pointed at a scratch ring meanwhile. */
+static void MeasureProfilerOverhead(void)
+{
+    static u32 const CalibrationAnchor = RegisterProfileAnchor("(overhead calibration)");
+    
+    profile_thread *Thread = GetProfilerThread();
+    static profile_thread Saved;
+    Saved = *Thread;
+    
+#ifdef PROFILER_TIMELINE_FILE
+    Thread->Timeline = (profile_timeline_event *)calloc(PROFILER_TIMELINE_EVENTS, sizeof(profile_timeline_event));
+#endif
+    
+    u32 const BatchCount = 64;
+    u32 const BlocksPerBatch = 256;
+    
+    u64 MinInside = (u64)-1;
+    u64 MinOutside = (u64)-1;
+    for(u32 BatchIndex = 0; BatchIndex < BatchCount; ++BatchIndex)
+    {
+        u64 InsideStart = Thread->Anchors[CalibrationAnchor].TSCElapsedInclusive;
+        
+        u64 Start = READ_BLOCK_TIMER();
+        for(u32 BlockIndex = 0; BlockIndex < BlocksPerBatch; ++BlockIndex)
+        {
+            profile_block Block(CalibrationAnchor, 0);
+        }
+        u64 Total = READ_BLOCK_TIMER() - Start;
+        
+        u64 Inside = Thread->Anchors[CalibrationAnchor].TSCElapsedInclusive - InsideStart;
+        u64 Outside = (Total > Inside) ? (Total - Inside) : 0;
+        
+        if(MinInside > Inside) MinInside = Inside;
+        if(MinOutside > Outside) MinOutside = Outside;
+    }
+    
+#ifdef PROFILER_TIMELINE_FILE
+    free(Thread->Timeline);
+#endif
+    *Thread = Saved;
+    
+    profiler_globals *Globals = GetProfilerGlobals();
+    Globals->OverheadInsideBlock = (f64)MinInside / (f64)BlocksPerBatch;
+    Globals->OverheadOutsideBlock = (f64)MinOutside / (f64)BlocksPerBatch;
+}
+
+static void SubtractClamped(u64 *Value, f64 Amount)
+{
+    u64 Ticks = (u64)(Amount + 0.5);
+    *Value = (*Value > Ticks) ? (*Value - Ticks) : 0;
+}
+
+/* NOTE: How many blocks ran inside of a block is exactly what the call tree records, so the
+   overhead can be subtracted after the fact without counting anything extra while running.
+   For a path node with N hits whose children were hit C times and whose whole subtree below
+   it was hit D times:
+     exclusive overhead = N*Inside + C*Outside
+     inclusive overhead = N*Inside + D*(Inside + Outside)
+   The same exclusive amount comes off the node's anchor. Inclusive anchor time only counts
+   the outermost call of a recursive block, so only nodes without an ancestor of the same
+   anchor take their inclusive amount off the anchor. Returns D. */
+static u64 SubtractPathOverhead(profile_thread *Thread, u32 PathIndex, u32 *AnchorDepth, f64 Inside, f64 Outside)
+{
+    profile_path_node *Path = Thread->Paths + PathIndex;
+    
+    ++AnchorDepth[Path->AnchorIndex];
+    u64 ChildHitCount = 0;
+    u64 DescendantHitCount = 0;
+    for(u32 ChildIndex = Path->FirstChild;
+        ChildIndex;
+        ChildIndex = Thread->Paths[ChildIndex].NextSibling)
+    {
+        u64 ChildHits = Thread->Paths[ChildIndex].HitCount;
+        ChildHitCount += ChildHits;
+        DescendantHitCount += ChildHits + SubtractPathOverhead(Thread, ChildIndex, AnchorDepth, Inside, Outside);
+    }
+    --AnchorDepth[Path->AnchorIndex];
+    
+    if(PathIndex)
+    {
+        f64 Exclusive = (f64)Path->HitCount*Inside + (f64)ChildHitCount*Outside;
+        f64 Inclusive = (f64)Path->HitCount*Inside + (f64)DescendantHitCount*(Inside + Outside);
+        
+        SubtractClamped(&Path->TSCElapsedExclusive, Exclusive);
+        SubtractClamped(&Path->TSCElapsedInclusive, Inclusive);
+        
+        profile_anchor *Anchor = Thread->Anchors + Path->AnchorIndex;
+        SubtractClamped(&Anchor->TSCElapsedExclusive, Exclusive);
+        if(AnchorDepth[Path->AnchorIndex] == 0)
+        {
+            SubtractClamped(&Anchor->TSCElapsedInclusive, Inclusive);
+        }
+    }
+    
+    return DescendantHitCount;
+}
+
+static void PrintProfilerOverhead(u32 ThreadCount, u64 TotalTSCElapsed, u64 TimerFreq)
+{
+    profiler_globals *Globals = GetProfilerGlobals();
+    f64 PerBlock = Globals->OverheadInsideBlock + Globals->OverheadOutsideBlock;
+    
+    u64 BlockCount = 0;
+    b32 PathsOverflowed = false;
+    for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profile_thread *Thread = Globals->Threads + ThreadIndex;
+        for(u32 AnchorIndex = 0; AnchorIndex < MAX_PROFILER_ANCHORS; ++AnchorIndex)
+        {
+            BlockCount += Thread->Anchors[AnchorIndex].HitCount;
+        }
+        PathsOverflowed |= Thread->PathsOverflowed;
+    }
+    
+    f64 OverheadTicks = (f64)BlockCount*PerBlock;
+    printf("\nProfiler overhead: %.1f per block (%.1f inside, %.1f outside), %llu blocks, ~%.0f total",
+           PerBlock, Globals->OverheadInsideBlock, Globals->OverheadOutsideBlock, BlockCount, OverheadTicks);
+    if(TimerFreq)
+    {
+        printf(" = %.4fms", 1000.0*OverheadTicks / (f64)TimerFreq);
+    }
+    printf(" (%.2f%% of total time, summed over threads)\n", 100.0*OverheadTicks / (f64)TotalTSCElapsed);
+    
+#if PROFILER_SUBTRACT_OVERHEAD
+    printf("Overhead has been subtracted from all times below.\n");
+    if(PathsOverflowed)
+    {
+        printf("  WARNING: Blocks missing from the call tree are not corrected.\n");
+    }
+#endif
+}
+
+static void PrintAnchorData(u64 TotalTSCElapsed, u64 TimerFreq)
+{
+    profiler_globals *Globals = GetProfilerGlobals();
+    
+    u32 ThreadCount = Globals->ThreadCount;
+    if(ThreadCount > MAX_PROFILER_THREADS)
+    {
+        printf("WARNING: %u threads were profiled, but there are only tables for %u. The last table is unreliable.\n",
+               ThreadCount, MAX_PROFILER_THREADS);
+        ThreadCount = MAX_PROFILER_THREADS;
+    }
+    
+    u32 AnchorCount = Globals->AnchorCount;
+    if(AnchorCount >= (MAX_PROFILER_ANCHORS - 1))
+    {
+        printf("WARNING: %u profile points were registered, but there are only %u anchors. The last anchor sums up the rest.\n",
+               AnchorCount, MAX_PROFILER_ANCHORS - 2);
+    }
+    
+    PrintProfilerOverhead(ThreadCount, TotalTSCElapsed, TimerFreq);
+    
+#if PROFILER_PERF_COUNTERS
+    for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profile_perf_counters *Counters = &Globals->Threads[ThreadIndex].PerfCounters;
+        if(!Counters->IsOpen)
+        {
+            printf("WARNING: Performance counters could not be opened for thread %u (%s).\n",
+                   ThreadIndex, strerror(Counters->OpenError));
+        }
+        else if(!Counters->UseRDPMC)
+        {
+            printf("NOTE: rdpmc is not available for thread %u, counters are read with a syscall per block.\n", ThreadIndex);
+        }
+    }
+#endif
+    
+#if PROFILER_SUBTRACT_OVERHEAD
+    for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        static u32 AnchorDepth[MAX_PROFILER_ANCHORS];
+        SubtractPathOverhead(Globals->Threads + ThreadIndex, 0, AnchorDepth,
+                             Globals->OverheadInsideBlock, Globals->OverheadOutsideBlock);
+    }
+#endif
+    
+    /* NOTE: Anchors are identified by the same index on every thread, so merging is just
+       summing the tables. A time in the merged table is the sum over all threads, which
+       means its percentage of the total wall time can be above 100% when threads overlap. */
+    static profile_anchor Merged[MAX_PROFILER_ANCHORS];
+    for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        profile_thread *Thread = Globals->Threads + ThreadIndex;
+        
+        if(ThreadCount > 1)
+        {
+            printf("\nThread %u:\n", ThreadIndex);
+        }
+        
+        for(u32 AnchorIndex = 0; AnchorIndex < ArrayCount(Thread->Anchors); ++AnchorIndex)
+        {
+            profile_anchor *Anchor = Thread->Anchors + AnchorIndex;
+            if(Anchor->HitCount)
+            {
+                PrintTimeElapsed(TotalTSCElapsed, TimerFreq, GetAnchorLabel(AnchorIndex), Anchor);
+                
+                profile_anchor *Sum = Merged + AnchorIndex;
+                Sum->TSCElapsedExclusive += Anchor->TSCElapsedExclusive;
+                Sum->TSCElapsedInclusive += Anchor->TSCElapsedInclusive;
+                Sum->HitCount += Anchor->HitCount;
+                Sum->ProcessedByteCount += Anchor->ProcessedByteCount;
+#if PROFILER_PERF_COUNTERS
+                for(u32 CounterIndex = 0; CounterIndex < ProfileCounter_Count; ++CounterIndex)
+                {
+                    Sum->CountersExclusive[CounterIndex] += Anchor->CountersExclusive[CounterIndex];
+                    Sum->CountersInclusive[CounterIndex] += Anchor->CountersInclusive[CounterIndex];
+                }
+#endif
+            }
+        }
+    }
+    
+    if(ThreadCount > 1)
+    {
+        printf("\nAll threads (summed, percentages of wall time):\n");
+        for(u32 AnchorIndex = 0; AnchorIndex < ArrayCount(Merged); ++AnchorIndex)
+        {
+            profile_anchor *Anchor = Merged + AnchorIndex;
+            if(Anchor->HitCount)
+            {
+                PrintTimeElapsed(TotalTSCElapsed, TimerFreq, GetAnchorLabel(AnchorIndex), Anchor);
+            }
+        }
+    }
+    
+    PrintCallTrees(ThreadCount, TotalTSCElapsed);
+    
+#ifdef PROFILER_COLLAPSED_STACKS_FILE
+    WriteCollapsedStacks(PROFILER_COLLAPSED_STACKS_FILE, ThreadCount);
+#endif
+}
+
+#else
+
+#define TimeBlock(...)
+#define TimeBandwidth(...)
+#define PrintAnchorData(...)
+#define MeasureProfilerOverhead(...)
+#define ProfilerEndOfCompilationUnit
+
+#endif
+
+struct profiler
+{
+    u64 StartTSC;
+    u64 EndTSC;
+};
+static profiler GlobalProfiler;
+
+#define TimeFunction TimeBlock(__func__)
+
+static u64 EstimateBlockTimerFreq(void)
+{
+    (void)&EstimateCPUTimerFreq; // NOTE(casey): This has to be voided here to prevent compilers from warning us that it is not used
+    
+	u64 MillisecondsToWait = 100;
+	u64 OSFreq = GetOSTimerFreq();
+
+	u64 BlockStart = READ_BLOCK_TIMER();
+	u64 OSStart = ReadOSTimer();
+	u64 OSEnd = 0;
+	u64 OSElapsed = 0;
+	u64 OSWaitTime = OSFreq * MillisecondsToWait / 1000;
+	while(OSElapsed < OSWaitTime)
+	{
+		OSEnd = ReadOSTimer();
+		OSElapsed = OSEnd - OSStart;
+	}
+	
+	u64 BlockEnd = READ_BLOCK_TIMER();
+	u64 BlockElapsed = BlockEnd - BlockStart;
+	
+	u64 BlockFreq = 0;
+	if(OSElapsed)
+	{
+		BlockFreq = OSFreq * BlockElapsed / OSElapsed;
+	}
+	
+	return BlockFreq;
+}
+
+static void BeginProfile(void)
+{
+    MeasureProfilerOverhead();
+    GlobalProfiler.StartTSC = READ_BLOCK_TIMER();
+}
+
+/* NOTE: All threads that were profiled have to be finished (joined) before this is called,
+   otherwise their tables are read while they are still being written. */
+static void EndAndPrintProfile()
+{
+    GlobalProfiler.EndTSC = READ_BLOCK_TIMER();
+    u64 TimerFreq = EstimateBlockTimerFreq();
+    
+    u64 TotalTSCElapsed = GlobalProfiler.EndTSC - GlobalProfiler.StartTSC;
+    
+    if(TimerFreq)
+    {
+        printf("\nTotal time: %0.4fms (timer freq %llu)\n", 1000.0 * (f64)TotalTSCElapsed / (f64)TimerFreq, TimerFreq);
+    }
+    
+    PrintAnchorData(TotalTSCElapsed, TimerFreq);
+    
+#if PROFILER && defined(PROFILER_TIMELINE_FILE)
+    WriteTimeline(PROFILER_TIMELINE_FILE, GlobalProfiler.StartTSC, TimerFreq);
+#endif
+}
@@ -0,0 +1,313 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 118
+   ======================================================================== */
+
+#if _WIN32
+
+#include <intrin.h>
+#include <windows.h>
+#include <psapi.h>
+
+#pragma comment (lib, "psapi.lib")
+
+static u64 GetOSTimerFreq(void)
+{
+	LARGE_INTEGER Freq;
+	QueryPerformanceFrequency(&Freq);
+	return Freq.QuadPart;
+}
+
+static u64 ReadOSTimer(void)
+{
+	LARGE_INTEGER Value;
+	QueryPerformanceCounter(&Value);
+	return Value.QuadPart;
+}
+
+static void ReadCPUID(u32 Leaf, u32 *Registers)
+{
+	int Values[4];
+	__cpuidex(Values, (int)Leaf, 0);
+	for(u32 Index = 0; Index < 4; ++Index)
+	{
+		Registers[Index] = (u32)Values[Index];
+	}
+}
+
+static u64 ReadKernelTSCFreq(void)
+{
+	// NOTE: Windows does not report the frequency it uses for the TSC anywhere.
+	return 0;
+}
+
+static u64 ReadOSPageFaultCount(void)
+{
+	PROCESS_MEMORY_COUNTERS_EX MemoryCounters = {};
+	MemoryCounters.cb = sizeof(MemoryCounters);
+	GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS *)&MemoryCounters, sizeof(MemoryCounters));
+	
+	u64 Result = MemoryCounters.PageFaultCount;
+	return Result;
+}
+
+#else
+
+#include <x86intrin.h>
+#include <cpuid.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/* NOTE: The OS timer is CLOCK_MONOTONIC_RAW rather than gettimeofday. It has nanosecond
+   resolution instead of microseconds, it never jumps when the wall clock is set, and unlike
+   CLOCK_MONOTONIC it is not slewed by NTP, so it ticks at the same rate as the TSC. That
+   makes a CPU timer calibration against it accurate after a few milliseconds. */
+static u64 GetOSTimerFreq(void)
+{
+	return 1000000000;
+}
+
+static u64 ReadOSTimer(void)
+{
+	struct timespec Value;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &Value);
+	
+	u64 Result = GetOSTimerFreq()*(u64)Value.tv_sec + (u64)Value.tv_nsec;
+	return Result;
+}
+
+static void ReadCPUID(u32 Leaf, u32 *Registers)
+{
+	__cpuid_count(Leaf, 0, Registers[0], Registers[1], Registers[2], Registers[3]);
+}
+
+/* NOTE: Mainline kernels keep tsc_khz to themselves, but some kernels (and some cloud
+   images) export it here. If it is there, it is the exact value the kernel uses. */
+static u64 ReadKernelTSCFreq(void)
+{
+	u64 Result = 0;
+	
+	FILE *File = fopen("/sys/devices/system/cpu/cpu0/tsc_freq_khz", "rb");
+	if(File)
+	{
+		unsigned long long KHz = 0;
+		if(fscanf(File, "%llu", &KHz) == 1)
+		{
+			Result = 1000*(u64)KHz;
+		}
+		fclose(File);
+	}
+	
+	return Result;
+}
+
+static u64 ReadOSPageFaultCount(void)
+{
+	// NOTE: Windows counts soft and hard faults together, so both are added here
+	// to get comparable numbers on Linux.
+	struct rusage Usage = {};
+	getrusage(RUSAGE_SELF, &Usage);
+	
+	u64 Result = (u64)Usage.ru_minflt + (u64)Usage.ru_majflt;
+	return Result;
+}
+
+#endif
+
+/* NOTE(casey): This does not need to be "inline", it could just be "static"
+   because compilers will inline it anyway. But compilers will warn about 
+   static functions that aren't used. So "inline" is just the simplest way 
+   to tell them to stop complaining about that. */
+inline u64 ReadCPUTimer(void)
+{
+	// NOTE(casey): If you were on ARM, you would need to replace __rdtsc
+	// with one of their performance counter read instructions, depending
+	// on which ones are available on your platform.
+	
+	return __rdtsc();
+}
+
+static u64 EstimateCPUTimerFreq(void)
+{
+	u64 MillisecondsToWait = 100;
+	u64 OSFreq = GetOSTimerFreq();
+
+	u64 CPUStart = ReadCPUTimer();
+	u64 OSStart = ReadOSTimer();
+	u64 OSEnd = 0;
+	u64 OSElapsed = 0;
+	u64 OSWaitTime = OSFreq * MillisecondsToWait / 1000;
+	while(OSElapsed < OSWaitTime)
+	{
+		OSEnd = ReadOSTimer();
+		OSElapsed = OSEnd - OSStart;
+	}
+	
+	u64 CPUEnd = ReadCPUTimer();
+	u64 CPUElapsed = CPUEnd - CPUStart;
+	
+	u64 CPUFreq = 0;
+	if(OSElapsed)
+	{
+		CPUFreq = OSFreq * CPUElapsed / OSElapsed;
+	}
+	
+	return CPUFreq;
+}
+
+/* NOTE: Reads the OS timer and the CPU timer as a pair that refers to (almost) the same
+   instant. The OS timer read is bracketed by two CPU timer reads and the tightest of a few
+   tries is kept, so a preemption or a slow OS timer call cannot skew the pair. */
+static void ReadTimerPair(u64 *OSValue, u64 *CPUValue)
+{
+	u64 BestSpread = (u64)-1;
+	for(u32 Try = 0; Try < 8; ++Try)
+	{
+		u64 CPUBefore = ReadCPUTimer();
+		u64 OSTime = ReadOSTimer();
+		u64 CPUAfter = ReadCPUTimer();
+		
+		u64 Spread = CPUAfter - CPUBefore;
+		if(BestSpread > Spread)
+		{
+			BestSpread = Spread;
+			*OSValue = OSTime;
+			*CPUValue = CPUBefore + Spread/2;
+		}
+	}
+}
+
+static u64 CalibrateCPUTimerFreq(u64 MillisecondsToWait)
+{
+	u64 OSFreq = GetOSTimerFreq();
+	u64 OSWaitTime = OSFreq * MillisecondsToWait / 1000;
+	
+	u64 OSStart = 0, CPUStart = 0;
+	ReadTimerPair(&OSStart, &CPUStart);
+	
+	while((ReadOSTimer() - OSStart) < OSWaitTime)
+	{
+	}
+	
+	u64 OSEnd = 0, CPUEnd = 0;
+	ReadTimerPair(&OSEnd, &CPUEnd);
+	
+	u64 OSElapsed = OSEnd - OSStart;
+	u64 CPUElapsed = CPUEnd - CPUStart;
+	
+	u64 CPUFreq = 0;
+	if(OSElapsed)
+	{
+		CPUFreq = (u64)((f64)OSFreq * (f64)CPUElapsed / (f64)OSElapsed);
+	}
+	
+	return CPUFreq;
+}
+
+struct cpu_timer_freq
+{
+	u64 Freq;
+	char const *Source;
+};
+
+/* NOTE: The TSC frequency is asked for in order of how exact the answer is:
+     - CPUID leaf 15h gives the TSC/crystal ratio and (usually) the crystal frequency.
+       If the crystal frequency is missing, the base frequency from leaf 16h is what
+       the TSC runs at on those parts.
+     - Hypervisors that implement the timing leaf 40000010h report the TSC in kHz.
+     - The kernel's tsc_khz, where it is exported.
+   Each of these takes microseconds. Only if none of them is available is the TSC
+   calibrated against the OS timer, which takes CalibrationMilliseconds instead of the
+   100ms EstimateCPUTimerFreq waits. */
+static cpu_timer_freq DetectCPUTimerFreq(void)
+{
+	u64 CalibrationMilliseconds = 10;
+	
+	cpu_timer_freq Result = {};
+	u32 Registers[4];
+	
+	ReadCPUID(0, Registers);
+	u32 MaxLeaf = Registers[0];
+	
+	if(MaxLeaf >= 0x15)
+	{
+		ReadCPUID(0x15, Registers);
+		u64 Denominator = Registers[0];
+		u64 Numerator = Registers[1];
+		u64 CrystalFreq = Registers[2];
+		
+		if(Denominator && Numerator)
+		{
+			if(CrystalFreq)
+			{
+				Result.Freq = CrystalFreq * Numerator / Denominator;
+				Result.Source = "CPUID 15h";
+			}
+			else if(MaxLeaf >= 0x16)
+			{
+				ReadCPUID(0x16, Registers);
+				u64 BaseMHz = Registers[0] & 0xFFFF;
+				if(BaseMHz)
+				{
+					Result.Freq = BaseMHz * 1000000;
+					Result.Source = "CPUID 16h";
+				}
+			}
+		}
+	}
+	
+	if(!Result.Freq)
+	{
+		ReadCPUID(1, Registers);
+		b32 UnderHypervisor = (Registers[2] >> 31) & 1;
+		if(UnderHypervisor)
+		{
+			ReadCPUID(0x40000000, Registers);
+			if(Registers[0] >= 0x40000010)
+			{
+				ReadCPUID(0x40000010, Registers);
+				if(Registers[0])
+				{
+					Result.Freq = 1000*(u64)Registers[0];
+					Result.Source = "hypervisor CPUID 40000010h";
+				}
+			}
+		}
+	}
+	
+	if(!Result.Freq)
+	{
+		Result.Freq = ReadKernelTSCFreq();
+		Result.Source = "kernel tsc_freq_khz";
+	}
+	
+	if(!Result.Freq)
+	{
+		Result.Freq = CalibrateCPUTimerFreq(CalibrationMilliseconds);
+		Result.Source = "calibrated against OS timer";
+	}
+	
+	return Result;
+}
+
+static u64 GetCPUTimerFreq(void)
+{
+	static u64 Freq;
+	if(!Freq)
+	{
+		Freq = DetectCPUTimerFreq().Freq;
+	}
+	
+	return Freq;
+}
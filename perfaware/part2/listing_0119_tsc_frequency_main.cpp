@@ -0,0 +1,76 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 119
+   ======================================================================== */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef int32_t b32;
+
+typedef float f32;
+typedef double f64;
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+#include "listing_0118_tsc_frequency.cpp"
+
+static void PrintFreq(char const *Label, u64 Freq, u64 OSElapsed, u64 Reference)
+{
+	f64 Milliseconds = 1000.0*(f64)OSElapsed / (f64)GetOSTimerFreq();
+	printf("%-28s %14llu (%.4fGHz) in %10.4fms", Label, Freq, (f64)Freq / 1000000000.0, Milliseconds);
+	if(Reference)
+	{
+		f64 PartsPerMillion = 1000000.0*((f64)Freq - (f64)Reference) / (f64)Reference;
+		printf("  %+.1fppm", PartsPerMillion);
+	}
+	printf("\n");
+}
+
+int main(void)
+{
+	(void)&ReadOSPageFaultCount; // NOTE: Not used here, voided so compilers do not warn about it
+	
+	u64 OSStart = ReadOSTimer();
+	cpu_timer_freq Detected = DetectCPUTimerFreq();
+	u64 DetectElapsed = ReadOSTimer() - OSStart;
+	
+	OSStart = ReadOSTimer();
+	u64 Calibrated = CalibrateCPUTimerFreq(10);
+	u64 CalibrateElapsed = ReadOSTimer() - OSStart;
+	
+	OSStart = ReadOSTimer();
+	u64 Estimated = EstimateCPUTimerFreq();
+	u64 EstimateElapsed = ReadOSTimer() - OSStart;
+	
+	// NOTE: The first call detects, every later call returns the cached value.
+	GetCPUTimerFreq();
+	OSStart = ReadOSTimer();
+	u64 Cached = GetCPUTimerFreq();
+	u64 CachedElapsed = ReadOSTimer() - OSStart;
+	
+	printf("Detected via %s\n\n", Detected.Source);
+	PrintFreq("DetectCPUTimerFreq:", Detected.Freq, DetectElapsed, 0);
+	PrintFreq("GetCPUTimerFreq (cached):", Cached, CachedElapsed, 0);
+	PrintFreq("CalibrateCPUTimerFreq(10):", Calibrated, CalibrateElapsed, Detected.Freq);
+	PrintFreq("EstimateCPUTimerFreq:", Estimated, EstimateElapsed, Detected.Freq);
+	
+	return 0;
+}
@@ -0,0 +1,210 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 123
+   ======================================================================== */
+
+
+/* NOTE: Formats a double exactly like printf("%.*f") does, without going through printf.
+   The double is Mantissa/2^Shift, so Mantissa*10^Precision/2^Shift rounded to the nearest
+   integer (ties to even, like glibc) is the exact decimal result. Mantissa is at most 53
+   bits and 10^17 at most 57, so the product always fits in 128 bits. Values that do not
+   fit this scheme (too many digits, too large, NaN, infinity) fall back to sprintf. */
+
+#define MAX_FIXED_F64_PRECISION 17
+
+static u64 const PowersOf10[] =
+{
+    1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull,
+    100000000000000000ull,
+    1000000000000000000ull,
+    10000000000000000000ull,
+};
+
+static char const DigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static void Multiply64x64(u64 A, u64 B, u64 *High, u64 *Low)
+{
+    u64 ALow = (u32)A;
+    u64 AHigh = A >> 32;
+    u64 BLow = (u32)B;
+    u64 BHigh = B >> 32;
+    
+    u64 LowLow = ALow*BLow;
+    u64 LowHigh = ALow*BHigh;
+    u64 HighLow = AHigh*BLow;
+    u64 HighHigh = AHigh*BHigh;
+    
+    u64 Cross = (LowLow >> 32) + (u32)LowHigh + (u32)HighLow;
+    *Low = (Cross << 32) | (u32)LowLow;
+    *High = HighHigh + (LowHigh >> 32) + (HighLow >> 32) + (Cross >> 32);
+}
+
+// NOTE: Writes exactly DigitCount digits ending right before End, zero-padded on the left
+static void WriteDigitsBackwards(char *End, u64 Value, u32 DigitCount)
+{
+    while(DigitCount >= 2)
+    {
+        End -= 2;
+        memcpy(End, DigitPairs + 2*(Value % 100), 2);
+        Value /= 100;
+        DigitCount -= 2;
+    }
+    
+    if(DigitCount)
+    {
+        *--End = (char)('0' + (Value % 10));
+    }
+}
+
+static u32 CountDigits(u64 Value)
+{
+    u32 Result = 1;
+    while((Result < ArrayCount(PowersOf10)) && (Value >= PowersOf10[Result]))
+    {
+        ++Result;
+    }
+    return Result;
+}
+
+// NOTE: Shift must be at least 1. Returns false if the rounded Value*10^Precision does not fit in a u64.
+static b32 ScaleToFixed(u64 Mantissa, u32 Shift, u32 Precision, u64 *Result)
+{
+    u64 High, Low;
+    Multiply64x64(Mantissa, PowersOf10[Precision], &High, &Low);
+    
+    u64 Scaled = 0;
+    b32 RoundUp = false;
+    if(Shift >= 128)
+    {
+        // NOTE: The product is below 2^110, so it is less than half of 2^Shift
+    }
+    else if(Shift > 64)
+    {
+        u32 HighShift = Shift - 64;
+        u64 RemainderHigh = High & ((1ull << HighShift) - 1);
+        u64 HalfHigh = 1ull << (HighShift - 1);
+        Scaled = High >> HighShift;
+        RoundUp = ((RemainderHigh > HalfHigh) ||
+                   ((RemainderHigh == HalfHigh) && ((Low != 0) || (Scaled & 1))));
+    }
+    else if(Shift == 64)
+    {
+        u64 Half = 1ull << 63;
+        Scaled = High;
+        RoundUp = ((Low > Half) || ((Low == Half) && (Scaled & 1)));
+    }
+    else
+    {
+        if(High >> Shift)
+        {
+            return false;
+        }
+        
+        u64 Remainder = Low & ((1ull << Shift) - 1);
+        u64 Half = 1ull << (Shift - 1);
+        Scaled = (Low >> Shift) | (High << (64 - Shift));
+        RoundUp = ((Remainder > Half) || ((Remainder == Half) && (Scaled & 1)));
+    }
+    
+    if(RoundUp)
+    {
+        if(Scaled == U64Max)
+        {
+            return false;
+        }
+        ++Scaled;
+    }
+    
+    *Result = Scaled;
+    return true;
+}
+
+// NOTE: Returns one past the last character written. Never writes a terminating zero.
+static char *FormatFixedF64(char *Dest, f64 Value, u32 Precision)
+{
+    u64 Bits;
+    memcpy(&Bits, &Value, sizeof(Bits));
+    
+    b32 Negative = (b32)(Bits >> 63);
+    u32 BiasedExponent = (u32)((Bits >> 52) & 0x7FF);
+    u64 Mantissa = Bits & ((1ull << 52) - 1);
+    
+    u64 Scaled = 0;
+    b32 Fits = ((Precision <= MAX_FIXED_F64_PRECISION) && (BiasedExponent < 0x7FF));
+    if(Fits)
+    {
+        // NOTE: Denormals have no implicit one bit and the same scale as the smallest normal
+        u32 Shift = 1074;
+        if(BiasedExponent)
+        {
+            Mantissa |= (1ull << 52);
+            Shift = 1075 - BiasedExponent;
+        }
+        
+        // NOTE: Values of 2^52 and up are integers with Shift <= 0, those go to the fallback
+        Fits = ((BiasedExponent < 1075) && ScaleToFixed(Mantissa, Shift, Precision, &Scaled));
+    }
+    
+    if(!Fits)
+    {
+        return Dest + sprintf(Dest, "%.*f", (int)Precision, Value);
+    }
+    
+    u64 Integer = Scaled / PowersOf10[Precision];
+    u64 Fraction = Scaled % PowersOf10[Precision];
+    
+    if(Negative)
+    {
+        *Dest++ = '-';
+    }
+    
+    u32 IntegerDigits = CountDigits(Integer);
+    WriteDigitsBackwards(Dest + IntegerDigits, Integer, IntegerDigits);
+    Dest += IntegerDigits;
+    
+    if(Precision)
+    {
+        *Dest++ = '.';
+        WriteDigitsBackwards(Dest + Precision, Fraction, Precision);
+        Dest += Precision;
+    }
+    
+    return Dest;
+}
@@ -0,0 +1,63 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 125
+   ======================================================================== */
+
+/* NOTE: A binary, columnar alternative to the JSON input. A 64-byte header is followed by
+   the X0, Y0, X1 and Y1 columns, each an array of f64s. Columns are ColumnStride values
+   apart. The stride is rounded up to a whole cache line, which makes every column start
+   64-byte aligned, and a reader can map the file and use the columns in place. */
+
+// NOTE: "HVCOLNS1" in little-endian byte order
+#define HAVERSINE_BINARY_MAGIC 0x31534E4C4F435648ull
+
+enum haversine_column
+{
+    HaversineColumn_X0,
+    HaversineColumn_Y0,
+    HaversineColumn_X1,
+    HaversineColumn_Y1,
+    
+    HaversineColumn_Count,
+};
+
+struct haversine_binary_header
+{
+    u64 Magic;
+    u64 PairCount;
+    u64 Seed;
+    u64 ColumnStride;
+    f64 ExpectedSum;
+    u64 Reserved[3];
+};
+static_assert(sizeof(haversine_binary_header) == 64, "The columns must start on a cache line");
+
+struct haversine_columns
+{
+    u64 PairCount;
+    f64 *Column[HaversineColumn_Count];
+};
+
+static u64 GetHaversineColumnStride(u64 PairCount)
+{
+    u64 ValuesPerCacheLine = 64 / sizeof(f64);
+    u64 Result = (PairCount + ValuesPerCacheLine - 1) & ~(ValuesPerCacheLine - 1);
+    return Result;
+}
+
+static u64 GetHaversineColumnOffset(u64 ColumnStride, u32 Column, u64 PairIndex)
+{
+    u64 Result = sizeof(haversine_binary_header) + (Column*ColumnStride + PairIndex)*sizeof(f64);
+    return Result;
+}
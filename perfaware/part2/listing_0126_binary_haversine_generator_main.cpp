@@ -0,0 +1,436 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 126
+   ======================================================================== */
+
+/* NOTE(casey): _CRT_SECURE_NO_WARNINGS is here because otherwise we cannot
+   call fopen(). If we replace fopen() with fopen_s() to avoid the warning,
+   then the code doesn't compile on Linux anymore, since fopen_s() does not
+   exist there.
+   
+   What exactly the CRT maintainers were thinking when they made this choice,
+   I have no idea. */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t b32;
+typedef double f64;
+#define U64Max UINT64_MAX
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+#include "listing_0065_haversine_formula.cpp"
+#include "listing_0123_fixed_float_format.cpp"
+#include "listing_0125_binary_haversine_format.cpp"
+
+struct random_series
+{
+    u64 A, B, C, D;
+};
+
+static u64 RotateLeft(u64 V, int Shift)
+{
+    u64 Result = ((V << Shift) | (V >> (64-Shift)));
+    return Result;
+}
+
+static u64 RandomU64(random_series *Series)
+{
+    u64 A = Series->A;
+    u64 B = Series->B;
+    u64 C = Series->C;
+    u64 D = Series->D;
+    
+    u64 E = A - RotateLeft(B, 27);
+    
+    A = (B ^ RotateLeft(C, 17));
+    B = (C + D);
+    C = (D + E);
+    D = (E + A);
+    
+    Series->A = A;
+    Series->B = B;
+    Series->C = C;
+    Series->D = D;
+    
+    return D;
+}
+
+static random_series Seed(u64 Value)
+{
+    random_series Series = {};
+    
+    // NOTE(casey): This is the seed pattern for JSF generators, as per the original post
+    Series.A = 0xf1ea5eed;
+    Series.B = Value;
+    Series.C = Value;
+    Series.D = Value;
+    
+    u32 Count = 20;
+    while(Count--)
+    {
+        RandomU64(&Series);
+    }
+    
+    return Series;
+}
+
+static f64 RandomInRange(random_series *Series, f64 Min, f64 Max)
+{
+    f64 t = (f64)RandomU64(Series) / (f64)U64Max;
+    f64 Result = (1.0 - t)*Min + t*Max;
+    
+    return Result;
+}
+
+static FILE *Open(long long unsigned PairCount, char const *Label, char const *Extension)
+{
+    char Temp[256];
+    sprintf(Temp, "data_%llu_%s.%s", PairCount, Label, Extension);
+    FILE *Result = fopen(Temp, "wb");
+    if(!Result)
+    {
+        fprintf(stderr, "Unable to open \"%s\" for writing.\n", Temp);
+    }
+    
+    return Result;
+}
+
+static f64 RandomDegree(random_series *Series, f64 Center, f64 Radius, f64 MaxAllowed)
+{
+    f64 MinVal = Center - Radius;
+    if(MinVal < -MaxAllowed)
+    {
+        MinVal = -MaxAllowed;
+    }
+    
+    f64 MaxVal = Center + Radius;
+    if(MaxVal > MaxAllowed)
+    {
+        MaxVal = MaxAllowed;
+    }
+    
+    f64 Result = RandomInRange(Series, MinVal, MaxVal);
+    return Result;
+}
+
+/* NOTE: The pairs are generated in fixed-size blocks, and every block gets its own random
+   series. Which thread generates a block therefore makes no difference to its contents, and
+   since blocks are written strictly in order, the output is byte-identical for any thread
+   count. Block 0 is seeded with the seed itself, so in uniform mode the first block matches
+   what listing 66 generates. Clusters are numbered over the whole file and each has its
+   own series too, so a block can compute the cluster of any of its pairs on its own. */
+#define GENERATOR_BLOCK_PAIR_COUNT (64*1024)
+
+// NOTE: Longest line is 4 x "-180.0000000000000000" plus the fixed text, rounded up generously
+#define MAX_PAIR_TEXT_SIZE 192
+
+static char *AppendString(char *Dest, char const *String)
+{
+    size_t Length = strlen(String);
+    memcpy(Dest, String, Length);
+    return Dest + Length;
+}
+
+struct generator_settings
+{
+    u64 SeedValue;
+    u64 PairCount;
+    u64 BlockCount;
+    u64 ClusterPairCount; // NOTE: 0 in uniform mode
+    f64 SumCoef;
+};
+
+struct generator_output
+{
+    FILE *FlexJSON;
+    FILE *HaverAnswers;
+    FILE *BinaryColumns; // NOTE: 0 unless the binary format was requested
+    u64 ColumnStride;
+    
+    std::mutex Mutex;
+    std::condition_variable BlockWritten;
+    u64 NextBlockToWrite;
+    f64 Sum;
+};
+
+static void WriteAt(FILE *File, u64 Offset, void *Data, u64 Size)
+{
+#if _WIN32
+    _fseeki64(File, Offset, SEEK_SET);
+#else
+    fseeko(File, Offset, SEEK_SET);
+#endif
+    fwrite(Data, 1, Size, File);
+}
+
+static random_series SeedStream(u64 SeedValue, u64 StreamIndex)
+{
+    // NOTE: Neighbouring seed values are fine for JSF, the warm-up rounds in Seed() decorrelate them.
+    random_series Result = Seed(SeedValue + 0x9E3779B97F4A7C15ull*StreamIndex);
+    return Result;
+}
+
+static random_series SeedBlock(u64 SeedValue, u64 BlockIndex)
+{
+    return SeedStream(SeedValue, 2*BlockIndex);
+}
+
+static random_series SeedCluster(u64 SeedValue, u64 ClusterIndex)
+{
+    return SeedStream(SeedValue, 2*ClusterIndex + 1);
+}
+
+static void GenerateBlocks(generator_settings *Settings, generator_output *Output, u32 ThreadIndex, u32 ThreadCount)
+{
+    f64 MaxAllowedX = 180;
+    f64 MaxAllowedY = 90;
+    
+    char *Text = (char *)malloc(GENERATOR_BLOCK_PAIR_COUNT*MAX_PAIR_TEXT_SIZE);
+    f64 *Answers = (f64 *)malloc(GENERATOR_BLOCK_PAIR_COUNT*sizeof(f64));
+    f64 *Columns[HaversineColumn_Count] = {};
+    if(Output->BinaryColumns)
+    {
+        for(u32 Column = 0; Column < HaversineColumn_Count; ++Column)
+        {
+            Columns[Column] = (f64 *)malloc(GENERATOR_BLOCK_PAIR_COUNT*sizeof(f64));
+        }
+    }
+    
+    for(u64 BlockIndex = ThreadIndex; BlockIndex < Settings->BlockCount; BlockIndex += ThreadCount)
+    {
+        u64 FirstPair = BlockIndex*GENERATOR_BLOCK_PAIR_COUNT;
+        u64 OnePastLastPair = FirstPair + GENERATOR_BLOCK_PAIR_COUNT;
+        if(OnePastLastPair > Settings->PairCount)
+        {
+            OnePastLastPair = Settings->PairCount;
+        }
+        
+        random_series Series = SeedBlock(Settings->SeedValue, BlockIndex);
+        
+        u64 ClusterIndex = U64Max;
+        f64 XCenter = 0;
+        f64 YCenter = 0;
+        f64 XRadius = MaxAllowedX;
+        f64 YRadius = MaxAllowedY;
+        
+        char *At = Text;
+        f64 BlockSum = 0;
+        for(u64 PairIndex = FirstPair; PairIndex < OnePastLastPair; ++PairIndex)
+        {
+            if(Settings->ClusterPairCount && (ClusterIndex != (PairIndex / Settings->ClusterPairCount)))
+            {
+                ClusterIndex = PairIndex / Settings->ClusterPairCount;
+                random_series ClusterSeries = SeedCluster(Settings->SeedValue, ClusterIndex);
+                XCenter = RandomInRange(&ClusterSeries, -MaxAllowedX, MaxAllowedX);
+                YCenter = RandomInRange(&ClusterSeries, -MaxAllowedY, MaxAllowedY);
+                XRadius = RandomInRange(&ClusterSeries, 0, MaxAllowedX);
+                YRadius = RandomInRange(&ClusterSeries, 0, MaxAllowedY);
+            }
+            
+            f64 X0 = RandomDegree(&Series, XCenter, XRadius, MaxAllowedX);
+            f64 Y0 = RandomDegree(&Series, YCenter, YRadius, MaxAllowedY);
+            f64 X1 = RandomDegree(&Series, XCenter, XRadius, MaxAllowedX);
+            f64 Y1 = RandomDegree(&Series, YCenter, YRadius, MaxAllowedY);
+            
+            f64 EarthRadius = 6372.8;
+            f64 HaversineDistance = ReferenceHaversine(X0, Y0, X1, Y1, EarthRadius);
+            
+            BlockSum += Settings->SumCoef*HaversineDistance;
+            
+            char const *JSONSep = (PairIndex == (Settings->PairCount - 1)) ? "\n" : ",\n";
+            
+            // NOTE: Same text as "    {\"x0\":%.16f, \"y0\":%.16f, \"x1\":%.16f, \"y1\":%.16f}%s"
+            At = AppendString(At, "    {\"x0\":");
+            At = FormatFixedF64(At, X0, 16);
+            At = AppendString(At, ", \"y0\":");
+            At = FormatFixedF64(At, Y0, 16);
+            At = AppendString(At, ", \"x1\":");
+            At = FormatFixedF64(At, X1, 16);
+            At = AppendString(At, ", \"y1\":");
+            At = FormatFixedF64(At, Y1, 16);
+            At = AppendString(At, "}");
+            At = AppendString(At, JSONSep);
+            
+            Answers[PairIndex - FirstPair] = HaversineDistance;
+            
+            if(Output->BinaryColumns)
+            {
+                Columns[HaversineColumn_X0][PairIndex - FirstPair] = X0;
+                Columns[HaversineColumn_Y0][PairIndex - FirstPair] = Y0;
+                Columns[HaversineColumn_X1][PairIndex - FirstPair] = X1;
+                Columns[HaversineColumn_Y1][PairIndex - FirstPair] = Y1;
+            }
+        }
+        
+        /* NOTE: Only the thread holding the next block in file order may write. Everyone else
+           waits here with their finished block. The sum is also accumulated in block order,
+           so it comes out bit-identical no matter how many threads there are. */
+        std::unique_lock<std::mutex> Lock(Output->Mutex);
+        while(Output->NextBlockToWrite != BlockIndex)
+        {
+            Output->BlockWritten.wait(Lock);
+        }
+        
+        fwrite(Text, 1, (size_t)(At - Text), Output->FlexJSON);
+        fwrite(Answers, sizeof(f64), (size_t)(OnePastLastPair - FirstPair), Output->HaverAnswers);
+        Output->Sum += BlockSum;
+        
+        if(Output->BinaryColumns)
+        {
+            for(u32 Column = 0; Column < HaversineColumn_Count; ++Column)
+            {
+                u64 Offset = GetHaversineColumnOffset(Output->ColumnStride, Column, FirstPair);
+                WriteAt(Output->BinaryColumns, Offset, Columns[Column], (OnePastLastPair - FirstPair)*sizeof(f64));
+            }
+        }
+        
+        ++Output->NextBlockToWrite;
+        Output->BlockWritten.notify_all();
+    }
+    
+    for(u32 Column = 0; Column < HaversineColumn_Count; ++Column)
+    {
+        free(Columns[Column]);
+    }
+    free(Answers);
+    free(Text);
+}
+
+int main(int ArgCount, char **Args)
+{
+    if((ArgCount >= 4) && (ArgCount <= 6))
+    {
+        char const *MethodName = Args[1];
+        b32 Cluster = false;
+        if(strcmp(MethodName, "cluster") == 0)
+        {
+            Cluster = true;
+        }
+        else if(strcmp(MethodName, "uniform") != 0)
+        {
+            MethodName = "uniform";
+            fprintf(stderr, "WARNING: Unrecognized method name. Using 'uniform'.\n");
+        }
+        
+        u32 ThreadCount = std::thread::hardware_concurrency();
+        b32 WriteBinary = false;
+        for(int ArgIndex = 4; ArgIndex < ArgCount; ++ArgIndex)
+        {
+            if(strcmp(Args[ArgIndex], "binary") == 0)
+            {
+                WriteBinary = true;
+            }
+            else
+            {
+                ThreadCount = (u32)atoi(Args[ArgIndex]);
+            }
+        }
+        if(ThreadCount < 1)
+        {
+            ThreadCount = 1;
+        }
+        
+        u64 SeedValue = atoll(Args[2]);
+        
+        u64 MaxPairCount = (1ULL << 34);
+        u64 PairCount = atoll(Args[3]);
+        if(PairCount < MaxPairCount)
+        {
+            generator_settings Settings = {};
+            Settings.SeedValue = SeedValue;
+            Settings.PairCount = PairCount;
+            Settings.BlockCount = (PairCount + GENERATOR_BLOCK_PAIR_COUNT - 1) / GENERATOR_BLOCK_PAIR_COUNT;
+            Settings.ClusterPairCount = Cluster ? (1 + (PairCount / 64)) : 0;
+            Settings.SumCoef = 1.0 / (f64)PairCount;
+            
+            if(ThreadCount > Settings.BlockCount)
+            {
+                ThreadCount = (u32)(Settings.BlockCount ? Settings.BlockCount : 1);
+            }
+            
+            generator_output Output = {};
+            Output.FlexJSON = Open(PairCount, "flex", "json");
+            Output.HaverAnswers = Open(PairCount, "haveranswer", "f64");
+            
+            haversine_binary_header Header = {};
+            Header.Magic = HAVERSINE_BINARY_MAGIC;
+            Header.PairCount = PairCount;
+            Header.Seed = SeedValue;
+            Header.ColumnStride = GetHaversineColumnStride(PairCount);
+            if(WriteBinary)
+            {
+                Output.BinaryColumns = Open(PairCount, "columns", "bin");
+                Output.ColumnStride = Header.ColumnStride;
+            }
+            
+            if(Output.FlexJSON && Output.HaverAnswers && (Output.BinaryColumns || !WriteBinary))
+            {
+                fprintf(Output.FlexJSON, "{\"pairs\":[\n");
+                
+                std::thread *Threads = new std::thread[ThreadCount];
+                for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+                {
+                    Threads[ThreadIndex] = std::thread(GenerateBlocks, &Settings, &Output, ThreadIndex, ThreadCount);
+                }
+                for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+                {
+                    Threads[ThreadIndex].join();
+                }
+                delete [] Threads;
+                
+                fprintf(Output.FlexJSON, "]}\n");
+                fwrite(&Output.Sum, sizeof(Output.Sum), 1, Output.HaverAnswers);
+                
+                // NOTE: The header goes in last, once the expected sum is known
+                if(Output.BinaryColumns)
+                {
+                    Header.ExpectedSum = Output.Sum;
+                    WriteAt(Output.BinaryColumns, 0, &Header, sizeof(Header));
+                }
+        
+                fprintf(stdout, "Method: %s\n", MethodName);
+                fprintf(stdout, "Random seed: %llu\n", SeedValue);
+                fprintf(stdout, "Pair count: %llu\n", PairCount);
+                fprintf(stdout, "Thread count: %u\n", ThreadCount);
+                fprintf(stdout, "Expected sum: %.16f\n", Output.Sum);
+            }
+            
+            if(Output.FlexJSON) fclose(Output.FlexJSON);
+            if(Output.HaverAnswers) fclose(Output.HaverAnswers);
+            if(Output.BinaryColumns) fclose(Output.BinaryColumns);
+        }
+        else
+        {
+            fprintf(stderr, "To avoid accidentally generating massive files, number of pairs must be less than %llu.\n", MaxPairCount);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s [uniform/cluster] [random seed] [number of coordinate pairs to generate] [thread count (optional)] [binary (optional)]\n", Args[0]);
+    }
+    
+    return 0;
+}
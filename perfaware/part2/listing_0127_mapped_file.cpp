@@ -0,0 +1,114 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 127
+   ======================================================================== */
+
+/* NOTE: Maps a whole file read-only into memory. Nothing is copied, the pages come
+   straight from the OS file cache. */
+
+#if _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if _WIN32
+
+static buffer MapEntireFile(char *FileName)
+{
+    buffer Result = {};
+    
+    HANDLE File = CreateFileA(FileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(File != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER Size = {};
+        GetFileSizeEx(File, &Size);
+        
+        HANDLE Mapping = CreateFileMappingA(File, 0, PAGE_READONLY, 0, 0, 0);
+        if(Mapping)
+        {
+            // NOTE: The view keeps the file mapped after both handles are closed
+            Result.Data = (u8 *)MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+            if(Result.Data)
+            {
+                Result.Count = Size.QuadPart;
+            }
+            CloseHandle(Mapping);
+        }
+        CloseHandle(File);
+    }
+    
+    if(!Result.Data)
+    {
+        fprintf(stderr, "ERROR: Unable to map \"%s\".\n", FileName);
+    }
+    
+    return Result;
+}
+
+static void UnmapFile(buffer *Buffer)
+{
+    if(Buffer->Data)
+    {
+        UnmapViewOfFile(Buffer->Data);
+    }
+    *Buffer = {};
+}
+
+#else
+
+static buffer MapEntireFile(char *FileName)
+{
+    buffer Result = {};
+    
+    int File = open(FileName, O_RDONLY);
+    if(File >= 0)
+    {
+        struct stat Stat;
+        if((fstat(File, &Stat) == 0) && (Stat.st_size > 0))
+        {
+            /* NOTE: MAP_POPULATE faults every page in right here. Otherwise the page faults
+               would land in whatever touches the data first, and the sum would no longer
+               measure pure compute. */
+            void *Data = mmap(0, Stat.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, File, 0);
+            if(Data != MAP_FAILED)
+            {
+                Result.Data = (u8 *)Data;
+                Result.Count = Stat.st_size;
+            }
+        }
+        close(File);
+    }
+    
+    if(!Result.Data)
+    {
+        fprintf(stderr, "ERROR: Unable to map \"%s\".\n", FileName);
+    }
+    
+    return Result;
+}
+
+static void UnmapFile(buffer *Buffer)
+{
+    if(Buffer->Data)
+    {
+        munmap(Buffer->Data, Buffer->Count);
+    }
+    *Buffer = {};
+}
+
+#endif
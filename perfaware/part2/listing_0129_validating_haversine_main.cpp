@@ -0,0 +1,498 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 129
+   ======================================================================== */
+
+/* NOTE(casey): _CRT_SECURE_NO_WARNINGS is here because otherwise we cannot
+   call fopen(). If we replace fopen() with fopen_s() to avoid the warning,
+   then the code doesn't compile on Linux anymore, since fopen_s() does not
+   exist there.
+   
+   What exactly the CRT maintainers were thinking when they made this choice,
+   I have no idea. */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <thread>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef int32_t b32;
+
+typedef float f32;
+typedef double f64;
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+struct haversine_pair
+{
+    f64 X0, Y0;
+    f64 X1, Y1;
+};
+
+#define PROFILER 1
+#define PROFILER_SUBTRACT_OVERHEAD 1
+#if __linux__
+#define PROFILER_PERF_COUNTERS 1
+#endif
+#include "listing_0120_tsc_frequency_profiler.cpp"
+#include "listing_0065_haversine_formula.cpp"
+#include "listing_0068_buffer.cpp"
+#include "listing_0094_profiled_lookup_json_parser.cpp"
+#include "listing_0125_binary_haversine_format.cpp"
+#include "listing_0127_mapped_file.cpp"
+
+#define SUM_THREAD_COUNT 4
+
+static buffer ReadEntireFile(char *FileName)
+{
+    TimeFunction;
+    
+    buffer Result = {};
+        
+    FILE *File = fopen(FileName, "rb");
+    if(File)
+    {
+#if _WIN32
+        struct __stat64 Stat;
+        _stat64(FileName, &Stat);
+#else
+        struct stat Stat;
+        stat(FileName, &Stat);
+#endif
+        
+        Result = AllocateBuffer(Stat.st_size);
+        if(Result.Data)
+        {
+            TimeBandwidth("fread", Result.Count);
+            if(fread(Result.Data, Result.Count, 1, File) != 1)
+            {
+                fprintf(stderr, "ERROR: Unable to read \"%s\".\n", FileName);
+                FreeBuffer(&Result);
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open \"%s\".\n", FileName);
+    }
+    
+    return Result;
+}
+
+static b32 GetHaversineColumns(buffer File, haversine_columns *Columns)
+{
+    *Columns = {};
+    
+    if(File.Count < sizeof(haversine_binary_header))
+    {
+        return false;
+    }
+    
+    haversine_binary_header *Header = (haversine_binary_header *)File.Data;
+    if(Header->Magic != HAVERSINE_BINARY_MAGIC)
+    {
+        return false;
+    }
+    
+    // NOTE: The padding after the last column is optional, only the values have to be there
+    u64 Stride = Header->ColumnStride;
+    if((Stride != GetHaversineColumnStride(Header->PairCount)) ||
+       (File.Count < GetHaversineColumnOffset(Stride, HaversineColumn_Count - 1, Header->PairCount)))
+    {
+        return false;
+    }
+    
+    Columns->PairCount = Header->PairCount;
+    for(u32 Column = 0; Column < HaversineColumn_Count; ++Column)
+    {
+        Columns->Column[Column] = (f64 *)(File.Data + GetHaversineColumnOffset(Stride, Column, 0));
+    }
+    
+    return true;
+}
+
+/* NOTE: With an answer file, every pair is checked against its reference distance while
+   the sum is computed. The answers are read straight out of the mapped file, next to the
+   inputs, so validation never needs a second full copy of the data. Each range keeps its
+   own statistics and they are merged in range order afterwards. */
+struct haversine_validation
+{
+    u64 MismatchCount;
+    u64 FirstMismatch; // NOTE: Only valid when MismatchCount is nonzero
+    f64 FirstMismatchValue;
+    f64 FirstMismatchAnswer;
+    
+    f64 MaxAbsError;
+    f64 SumAbsError;
+    u64 MaxULPError;
+};
+
+// NOTE: Maps the bits to integers that are ordered like the doubles, so the difference counts the representable values in between
+static u64 OrderedBitsOf(f64 Value)
+{
+    u64 Bits;
+    memcpy(&Bits, &Value, sizeof(Bits));
+    u64 Result = (Bits >> 63) ? ~Bits : (Bits | (1ull << 63));
+    return Result;
+}
+
+static u64 ULPDistance(f64 A, f64 B)
+{
+    u64 OrderedA = OrderedBitsOf(A);
+    u64 OrderedB = OrderedBitsOf(B);
+    u64 Result = (OrderedA > OrderedB) ? (OrderedA - OrderedB) : (OrderedB - OrderedA);
+    return Result;
+}
+
+static void ValidatePair(haversine_validation *Validation, u64 PairIndex, f64 Value, f64 Answer)
+{
+    f64 AbsError = fabs(Value - Answer);
+    Validation->SumAbsError += AbsError;
+    if(Validation->MaxAbsError < AbsError)
+    {
+        Validation->MaxAbsError = AbsError;
+    }
+    
+    u64 ULPError = ULPDistance(Value, Answer);
+    if(ULPError)
+    {
+        if(Validation->MaxULPError < ULPError)
+        {
+            Validation->MaxULPError = ULPError;
+        }
+        
+        if(Validation->MismatchCount++ == 0)
+        {
+            Validation->FirstMismatch = PairIndex;
+            Validation->FirstMismatchValue = Value;
+            Validation->FirstMismatchAnswer = Answer;
+        }
+    }
+}
+
+static void MergeValidation(haversine_validation *Dest, haversine_validation *Source)
+{
+    if((Dest->MismatchCount == 0) && Source->MismatchCount)
+    {
+        Dest->FirstMismatch = Source->FirstMismatch;
+        Dest->FirstMismatchValue = Source->FirstMismatchValue;
+        Dest->FirstMismatchAnswer = Source->FirstMismatchAnswer;
+    }
+    
+    Dest->MismatchCount += Source->MismatchCount;
+    Dest->SumAbsError += Source->SumAbsError;
+    if(Dest->MaxAbsError < Source->MaxAbsError)
+    {
+        Dest->MaxAbsError = Source->MaxAbsError;
+    }
+    if(Dest->MaxULPError < Source->MaxULPError)
+    {
+        Dest->MaxULPError = Source->MaxULPError;
+    }
+}
+
+static void PrintValidation(haversine_validation *Validation, u64 PairCount)
+{
+    fprintf(stdout, "Pairs checked: %llu\n", PairCount);
+    fprintf(stdout, "Max abs error: %.16e\n", Validation->MaxAbsError);
+    fprintf(stdout, "Mean abs error: %.16e\n", PairCount ? (Validation->SumAbsError / (f64)PairCount) : 0.0);
+    fprintf(stdout, "Max ULP error: %llu\n", Validation->MaxULPError);
+    if(Validation->MismatchCount)
+    {
+        fprintf(stdout, "Mismatches: %llu (first at pair %llu: %.16f, reference %.16f)\n",
+                Validation->MismatchCount, Validation->FirstMismatch,
+                Validation->FirstMismatchValue, Validation->FirstMismatchAnswer);
+    }
+    else
+    {
+        fprintf(stdout, "Mismatches: none, every distance matches bit for bit\n");
+    }
+}
+
+/* NOTE: A range either points into an array of parsed pairs, or into the four columns of
+   a binary input. Both are summed in the same order, so the same pairs give the same sum
+   no matter which format they came from. */
+struct haversine_sum_range
+{
+    u64 FirstPair;
+    u64 PairCount;
+    haversine_pair *Pairs;
+    f64 *Column[HaversineColumn_Count];
+    f64 *Answers; // NOTE: 0 when not validating
+    f64 SumCoef;
+    f64 Sum;
+    
+    haversine_validation Validation;
+};
+
+static void SumHaversineRange(haversine_sum_range *Range)
+{
+    TimeBandwidth(__func__, Range->PairCount*sizeof(haversine_pair));
+    
+    f64 Sum = 0;
+    f64 EarthRadius = 6372.8;
+    f64 *Answers = Range->Answers;
+    
+    if(Range->Pairs)
+    {
+        for(u64 PairIndex = 0; PairIndex < Range->PairCount; ++PairIndex)
+        {
+            haversine_pair Pair = Range->Pairs[PairIndex];
+            f64 Dist = ReferenceHaversine(Pair.X0, Pair.Y0, Pair.X1, Pair.Y1, EarthRadius);
+            Sum += Range->SumCoef*Dist;
+            
+            if(Answers)
+            {
+                ValidatePair(&Range->Validation, Range->FirstPair + PairIndex, Dist, Answers[PairIndex]);
+            }
+        }
+    }
+    else
+    {
+        f64 *X0 = Range->Column[HaversineColumn_X0];
+        f64 *Y0 = Range->Column[HaversineColumn_Y0];
+        f64 *X1 = Range->Column[HaversineColumn_X1];
+        f64 *Y1 = Range->Column[HaversineColumn_Y1];
+        for(u64 PairIndex = 0; PairIndex < Range->PairCount; ++PairIndex)
+        {
+            f64 Dist = ReferenceHaversine(X0[PairIndex], Y0[PairIndex], X1[PairIndex], Y1[PairIndex], EarthRadius);
+            Sum += Range->SumCoef*Dist;
+            
+            if(Answers)
+            {
+                ValidatePair(&Range->Validation, Range->FirstPair + PairIndex, Dist, Answers[PairIndex]);
+            }
+        }
+    }
+    
+    Range->Sum = Sum;
+}
+
+/* NOTE: Pass either Pairs or Columns, the other one has to be 0. Answers and Validation
+   are optional, when both are passed every pair gets checked against its answer. */
+static f64 SumHaversineDistances(u64 PairCount, haversine_pair *Pairs, haversine_columns *Columns,
+                                 f64 *Answers, haversine_validation *Validation)
+{
+    TimeFunction;
+    
+    /* NOTE: The pairs are split into one contiguous range per thread. The partial sums
+       are added in a fixed order, so the result only depends on the thread count. */
+    haversine_sum_range Ranges[SUM_THREAD_COUNT] = {};
+    std::thread Threads[SUM_THREAD_COUNT];
+    
+    f64 SumCoef = 1 / (f64)PairCount;
+    u64 PairsPerThread = (PairCount + SUM_THREAD_COUNT - 1) / SUM_THREAD_COUNT;
+    u64 FirstPair = 0;
+    for(u32 ThreadIndex = 0; ThreadIndex < SUM_THREAD_COUNT; ++ThreadIndex)
+    {
+        haversine_sum_range *Range = Ranges + ThreadIndex;
+        u64 RangeCount = PairCount - FirstPair;
+        if(RangeCount > PairsPerThread)
+        {
+            RangeCount = PairsPerThread;
+        }
+        
+        Range->FirstPair = FirstPair;
+        Range->PairCount = RangeCount;
+        if(Answers)
+        {
+            Range->Answers = Answers + FirstPair;
+        }
+        if(Pairs)
+        {
+            Range->Pairs = Pairs + FirstPair;
+        }
+        else
+        {
+            for(u32 Column = 0; Column < HaversineColumn_Count; ++Column)
+            {
+                Range->Column[Column] = Columns->Column[Column] + FirstPair;
+            }
+        }
+        Range->SumCoef = SumCoef;
+        FirstPair += RangeCount;
+        
+        Threads[ThreadIndex] = std::thread(SumHaversineRange, Range);
+    }
+    
+    f64 Sum = 0;
+    for(u32 ThreadIndex = 0; ThreadIndex < SUM_THREAD_COUNT; ++ThreadIndex)
+    {
+        Threads[ThreadIndex].join();
+        Sum += Ranges[ThreadIndex].Sum;
+        
+        if(Answers && Validation)
+        {
+            MergeValidation(Validation, &Ranges[ThreadIndex].Validation);
+        }
+    }
+    
+    return Sum;
+}
+
+static f64 SumHaversineJSON(char *FileName, u64 *InputSize, u64 *PairCount,
+                            buffer Answers, haversine_validation *Validation)
+{
+    f64 Sum = 0;
+    
+    buffer InputJSON = ReadEntireFile(FileName);
+    *InputSize = InputJSON.Count;
+    
+    u32 MinimumJSONPairEncoding = 6*4;
+    u64 MaxPairCount = InputJSON.Count / MinimumJSONPairEncoding;
+    if(MaxPairCount)
+    {
+        buffer ParsedValues = AllocateBuffer(MaxPairCount * sizeof(haversine_pair));
+        if(ParsedValues.Count)
+        {
+            haversine_pair *Pairs = (haversine_pair *)ParsedValues.Data;
+            
+            {
+                TimeBandwidth("Parse", InputJSON.Count);
+                *PairCount = ParseHaversinePairs(InputJSON, MaxPairCount, Pairs);
+            }
+            
+            /* NOTE: The pair count is only known after parsing. If it does not match the answer
+               file, the pairs cannot be lined up with their answers and only the sum is checked. */
+            f64 *AnswerValues = 0;
+            if(Answers.Count == (*PairCount + 1)*sizeof(f64))
+            {
+                AnswerValues = (f64 *)Answers.Data;
+            }
+            Sum = SumHaversineDistances(*PairCount, Pairs, 0, AnswerValues, Validation);
+        }
+        
+        FreeBuffer(&ParsedValues);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Malformed input JSON\n");
+    }
+    
+    FreeBuffer(&InputJSON);
+    
+    return Sum;
+}
+
+int main(int ArgCount, char **Args)
+{
+    BeginProfile();
+	
+    int Result = 1;
+    
+    if((ArgCount == 2) || (ArgCount == 3))
+    {
+        u64 InputSize = 0;
+        u64 PairCount = 0;
+        f64 Sum = 0;
+        
+        /* NOTE: The answers are mapped, not read. Only the pages the validation is currently
+           walking through have to be resident, next to the inputs. */
+        buffer AnswersF64 = {};
+        if(ArgCount == 3)
+        {
+            TimeBlock("Map answers");
+            AnswersF64 = MapEntireFile(Args[2]);
+        }
+        
+        u64 RefAnswerCount = 0;
+        if(AnswersF64.Count >= sizeof(f64))
+        {
+            RefAnswerCount = (AnswersF64.Count - sizeof(f64)) / sizeof(f64);
+        }
+        
+        haversine_validation Validation = {};
+        
+        /* NOTE: Binary inputs are recognized by their header and summed straight out of the
+           mapping. Anything else gets read and parsed as JSON like before. */
+        buffer InputMapping = {};
+        {
+            TimeBlock("Map input");
+            InputMapping = MapEntireFile(Args[1]);
+        }
+        
+        haversine_columns Columns = {};
+        if(GetHaversineColumns(InputMapping, &Columns))
+        {
+            InputSize = InputMapping.Count;
+            PairCount = Columns.PairCount;
+            
+            f64 *AnswerValues = (RefAnswerCount == PairCount) ? (f64 *)AnswersF64.Data : 0;
+            Sum = SumHaversineDistances(PairCount, 0, &Columns, AnswerValues, &Validation);
+            
+            haversine_binary_header *Header = (haversine_binary_header *)InputMapping.Data;
+            fprintf(stdout, "Binary input, seed %llu, expected sum %.16f\n", Header->Seed, Header->ExpectedSum);
+        }
+        else if(InputMapping.Data)
+        {
+            UnmapFile(&InputMapping);
+            Sum = SumHaversineJSON(Args[1], &InputSize, &PairCount, AnswersF64, &Validation);
+        }
+        
+        if(PairCount)
+        {
+            Result = 0;
+            
+            fprintf(stdout, "Input size: %llu\n", InputSize);
+            fprintf(stdout, "Pair count: %llu\n", PairCount);
+            fprintf(stdout, "Haversine sum: %.16f\n", Sum);
+            
+            if(AnswersF64.Count >= sizeof(f64))
+            {
+                f64 *AnswerValues = (f64 *)AnswersF64.Data;
+                
+                fprintf(stdout, "\nValidation:\n");
+                
+                if(PairCount != RefAnswerCount)
+                {
+                    fprintf(stdout, "FAILED - pair count doesn't match %llu.\n", RefAnswerCount);
+                }
+                else
+                {
+                    PrintValidation(&Validation, PairCount);
+                }
+                
+                f64 RefSum = AnswerValues[RefAnswerCount];
+                fprintf(stdout, "Reference sum: %.16f\n", RefSum);
+                fprintf(stdout, "Difference: %.16f\n", Sum - RefSum);
+                
+                fprintf(stdout, "\n");
+            }
+        }
+        
+        UnmapFile(&InputMapping);
+        UnmapFile(&AnswersF64);
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s [haversine_input.json or .bin]\n", Args[0]);
+        fprintf(stderr, "       %s [haversine_input.json or .bin] [answers.f64]\n", Args[0]);
+    }
+
+    if(Result == 0)
+	{
+        EndAndPrintProfile();
+	}
+		
+    return Result;
+}
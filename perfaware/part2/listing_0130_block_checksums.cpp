@@ -0,0 +1,73 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 130
+   ======================================================================== */
+
+
+/* NOTE: A small side file the generator writes next to the JSON, so a run can be checked
+   without the 8-bytes-per-pair answer file. For every block of HAVERSINE_CHECKSUM_BLOCK_PAIRS
+   pairs it stores the block's partial sum, exactly as the generator accumulated it, and a
+   hash of the text of the block's pair objects. The hash covers each object from its '{'
+   through its '}', so it does not depend on the whitespace and commas between them.
+   
+   Each block can be checked on its own, which lets the checking run in parallel and says
+   which block went wrong: a wrong hash means the input text changed, a right hash with a
+   wrong sum means the computation diverged. */
+
+#define HAVERSINE_CHECKSUM_BLOCK_PAIRS (64*1024)
+
+// NOTE: "HVBLOCK1" in little-endian byte order
+#define HAVERSINE_CHECKSUM_MAGIC 0x314B434F4C425648ull
+
+#define HAVERSINE_CHECKSUM_HASH_SEED 0x243F6A8885A308D3ull
+
+struct haversine_checksum_header
+{
+    u64 Magic;
+    u64 PairCount;
+    u64 BlockPairCount;
+    u64 BlockCount;
+    f64 ExpectedSum;
+    u64 Reserved[3];
+};
+
+struct haversine_block_checksum
+{
+    f64 Sum;
+    u64 TextHash;
+};
+
+/* NOTE: Consumes eight bytes per step. The tail is padded with zeros and tagged with its
+   length, so chaining the hash over consecutive objects cannot mix up where one ends. */
+static u64 HashBytes(u64 Hash, u8 const *Bytes, u64 Count)
+{
+    while(Count >= 8)
+    {
+        u64 Word;
+        memcpy(&Word, Bytes, sizeof(Word));
+        Hash = (Hash ^ Word)*0xFF51AFD7ED558CCDull;
+        Hash ^= (Hash >> 32);
+        
+        Bytes += 8;
+        Count -= 8;
+    }
+    
+    u64 Word = 0;
+    memcpy(&Word, Bytes, Count);
+    Word |= (Count << 56);
+    Hash = (Hash ^ Word)*0xC4CEB9FE1A85EC53ull;
+    Hash ^= (Hash >> 29);
+    
+    return Hash;
+}
@@ -0,0 +1,820 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* ========================================================================
+   LISTING 132
+   ======================================================================== */
+
+/* NOTE(casey): _CRT_SECURE_NO_WARNINGS is here because otherwise we cannot
+   call fopen(). If we replace fopen() with fopen_s() to avoid the warning,
+   then the code doesn't compile on Linux anymore, since fopen_s() does not
+   exist there.
+   
+   What exactly the CRT maintainers were thinking when they made this choice,
+   I have no idea. */
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <thread>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef int32_t b32;
+
+typedef float f32;
+typedef double f64;
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+struct haversine_pair
+{
+    f64 X0, Y0;
+    f64 X1, Y1;
+};
+
+#define PROFILER 1
+#define PROFILER_SUBTRACT_OVERHEAD 1
+#if __linux__
+#define PROFILER_PERF_COUNTERS 1
+#endif
+#include "listing_0120_tsc_frequency_profiler.cpp"
+#include "listing_0065_haversine_formula.cpp"
+#include "listing_0068_buffer.cpp"
+#include "listing_0094_profiled_lookup_json_parser.cpp"
+#include "listing_0125_binary_haversine_format.cpp"
+#include "listing_0127_mapped_file.cpp"
+#include "listing_0130_block_checksums.cpp"
+
+#define SUM_THREAD_COUNT 4
+
+static buffer ReadEntireFile(char *FileName)
+{
+    TimeFunction;
+    
+    buffer Result = {};
+        
+    FILE *File = fopen(FileName, "rb");
+    if(File)
+    {
+#if _WIN32
+        struct __stat64 Stat;
+        _stat64(FileName, &Stat);
+#else
+        struct stat Stat;
+        stat(FileName, &Stat);
+#endif
+        
+        Result = AllocateBuffer(Stat.st_size);
+        if(Result.Data)
+        {
+            TimeBandwidth("fread", Result.Count);
+            if(fread(Result.Data, Result.Count, 1, File) != 1)
+            {
+                fprintf(stderr, "ERROR: Unable to read \"%s\".\n", FileName);
+                FreeBuffer(&Result);
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open \"%s\".\n", FileName);
+    }
+    
+    return Result;
+}
+
+static b32 GetHaversineColumns(buffer File, haversine_columns *Columns)
+{
+    *Columns = {};
+    
+    if(File.Count < sizeof(haversine_binary_header))
+    {
+        return false;
+    }
+    
+    haversine_binary_header *Header = (haversine_binary_header *)File.Data;
+    if(Header->Magic != HAVERSINE_BINARY_MAGIC)
+    {
+        return false;
+    }
+    
+    // NOTE: The padding after the last column is optional, only the values have to be there
+    u64 Stride = Header->ColumnStride;
+    if((Stride != GetHaversineColumnStride(Header->PairCount)) ||
+       (File.Count < GetHaversineColumnOffset(Stride, HaversineColumn_Count - 1, Header->PairCount)))
+    {
+        return false;
+    }
+    
+    Columns->PairCount = Header->PairCount;
+    for(u32 Column = 0; Column < HaversineColumn_Count; ++Column)
+    {
+        Columns->Column[Column] = (f64 *)(File.Data + GetHaversineColumnOffset(Stride, Column, 0));
+    }
+    
+    return true;
+}
+
+/* NOTE: With an answer file, every pair is checked against its reference distance while
+   the sum is computed. The answers are read straight out of the mapped file, next to the
+   inputs, so validation never needs a second full copy of the data. Each range keeps its
+   own statistics and they are merged in range order afterwards. */
+struct haversine_validation
+{
+    u64 MismatchCount;
+    u64 FirstMismatch; // NOTE: Only valid when MismatchCount is nonzero
+    f64 FirstMismatchValue;
+    f64 FirstMismatchAnswer;
+    
+    f64 MaxAbsError;
+    f64 SumAbsError;
+    u64 MaxULPError;
+};
+
+// NOTE: Maps the bits to integers that are ordered like the doubles, so the difference counts the representable values in between
+static u64 OrderedBitsOf(f64 Value)
+{
+    u64 Bits;
+    memcpy(&Bits, &Value, sizeof(Bits));
+    u64 Result = (Bits >> 63) ? ~Bits : (Bits | (1ull << 63));
+    return Result;
+}
+
+static u64 ULPDistance(f64 A, f64 B)
+{
+    u64 OrderedA = OrderedBitsOf(A);
+    u64 OrderedB = OrderedBitsOf(B);
+    u64 Result = (OrderedA > OrderedB) ? (OrderedA - OrderedB) : (OrderedB - OrderedA);
+    return Result;
+}
+
+static void ValidatePair(haversine_validation *Validation, u64 PairIndex, f64 Value, f64 Answer)
+{
+    f64 AbsError = fabs(Value - Answer);
+    Validation->SumAbsError += AbsError;
+    if(Validation->MaxAbsError < AbsError)
+    {
+        Validation->MaxAbsError = AbsError;
+    }
+    
+    u64 ULPError = ULPDistance(Value, Answer);
+    if(ULPError)
+    {
+        if(Validation->MaxULPError < ULPError)
+        {
+            Validation->MaxULPError = ULPError;
+        }
+        
+        if(Validation->MismatchCount++ == 0)
+        {
+            Validation->FirstMismatch = PairIndex;
+            Validation->FirstMismatchValue = Value;
+            Validation->FirstMismatchAnswer = Answer;
+        }
+    }
+}
+
+static void MergeValidation(haversine_validation *Dest, haversine_validation *Source)
+{
+    if((Dest->MismatchCount == 0) && Source->MismatchCount)
+    {
+        Dest->FirstMismatch = Source->FirstMismatch;
+        Dest->FirstMismatchValue = Source->FirstMismatchValue;
+        Dest->FirstMismatchAnswer = Source->FirstMismatchAnswer;
+    }
+    
+    Dest->MismatchCount += Source->MismatchCount;
+    Dest->SumAbsError += Source->SumAbsError;
+    if(Dest->MaxAbsError < Source->MaxAbsError)
+    {
+        Dest->MaxAbsError = Source->MaxAbsError;
+    }
+    if(Dest->MaxULPError < Source->MaxULPError)
+    {
+        Dest->MaxULPError = Source->MaxULPError;
+    }
+}
+
+static void PrintValidation(haversine_validation *Validation, u64 PairCount)
+{
+    fprintf(stdout, "Pairs checked: %llu\n", PairCount);
+    fprintf(stdout, "Max abs error: %.16e\n", Validation->MaxAbsError);
+    fprintf(stdout, "Mean abs error: %.16e\n", PairCount ? (Validation->SumAbsError / (f64)PairCount) : 0.0);
+    fprintf(stdout, "Max ULP error: %llu\n", Validation->MaxULPError);
+    if(Validation->MismatchCount)
+    {
+        fprintf(stdout, "Mismatches: %llu (first at pair %llu: %.16f, reference %.16f)\n",
+                Validation->MismatchCount, Validation->FirstMismatch,
+                Validation->FirstMismatchValue, Validation->FirstMismatchAnswer);
+    }
+    else
+    {
+        fprintf(stdout, "Mismatches: none, every distance matches bit for bit\n");
+    }
+}
+
+/* NOTE: A range either points into an array of parsed pairs, or into the four columns of
+   a binary input. Both are summed in the same order, so the same pairs give the same sum
+   no matter which format they came from. */
+struct haversine_sum_range
+{
+    u64 FirstPair;
+    u64 PairCount;
+    haversine_pair *Pairs;
+    f64 *Column[HaversineColumn_Count];
+    f64 *Answers; // NOTE: 0 when not validating
+    f64 SumCoef;
+    f64 Sum;
+    
+    haversine_validation Validation;
+};
+
+static void SumHaversineRange(haversine_sum_range *Range)
+{
+    TimeBandwidth(__func__, Range->PairCount*sizeof(haversine_pair));
+    
+    f64 Sum = 0;
+    f64 EarthRadius = 6372.8;
+    f64 *Answers = Range->Answers;
+    
+    if(Range->Pairs)
+    {
+        for(u64 PairIndex = 0; PairIndex < Range->PairCount; ++PairIndex)
+        {
+            haversine_pair Pair = Range->Pairs[PairIndex];
+            f64 Dist = ReferenceHaversine(Pair.X0, Pair.Y0, Pair.X1, Pair.Y1, EarthRadius);
+            Sum += Range->SumCoef*Dist;
+            
+            if(Answers)
+            {
+                ValidatePair(&Range->Validation, Range->FirstPair + PairIndex, Dist, Answers[PairIndex]);
+            }
+        }
+    }
+    else
+    {
+        f64 *X0 = Range->Column[HaversineColumn_X0];
+        f64 *Y0 = Range->Column[HaversineColumn_Y0];
+        f64 *X1 = Range->Column[HaversineColumn_X1];
+        f64 *Y1 = Range->Column[HaversineColumn_Y1];
+        for(u64 PairIndex = 0; PairIndex < Range->PairCount; ++PairIndex)
+        {
+            f64 Dist = ReferenceHaversine(X0[PairIndex], Y0[PairIndex], X1[PairIndex], Y1[PairIndex], EarthRadius);
+            Sum += Range->SumCoef*Dist;
+            
+            if(Answers)
+            {
+                ValidatePair(&Range->Validation, Range->FirstPair + PairIndex, Dist, Answers[PairIndex]);
+            }
+        }
+    }
+    
+    Range->Sum = Sum;
+}
+
+/* NOTE: Pass either Pairs or Columns, the other one has to be 0. Answers and Validation
+   are optional, when both are passed every pair gets checked against its answer. */
+static f64 SumHaversineDistances(u64 PairCount, haversine_pair *Pairs, haversine_columns *Columns,
+                                 f64 *Answers, haversine_validation *Validation)
+{
+    TimeFunction;
+    
+    /* NOTE: The pairs are split into one contiguous range per thread. The partial sums
+       are added in a fixed order, so the result only depends on the thread count. */
+    haversine_sum_range Ranges[SUM_THREAD_COUNT] = {};
+    std::thread Threads[SUM_THREAD_COUNT];
+    
+    f64 SumCoef = 1 / (f64)PairCount;
+    u64 PairsPerThread = (PairCount + SUM_THREAD_COUNT - 1) / SUM_THREAD_COUNT;
+    u64 FirstPair = 0;
+    for(u32 ThreadIndex = 0; ThreadIndex < SUM_THREAD_COUNT; ++ThreadIndex)
+    {
+        haversine_sum_range *Range = Ranges + ThreadIndex;
+        u64 RangeCount = PairCount - FirstPair;
+        if(RangeCount > PairsPerThread)
+        {
+            RangeCount = PairsPerThread;
+        }
+        
+        Range->FirstPair = FirstPair;
+        Range->PairCount = RangeCount;
+        if(Answers)
+        {
+            Range->Answers = Answers + FirstPair;
+        }
+        if(Pairs)
+        {
+            Range->Pairs = Pairs + FirstPair;
+        }
+        else
+        {
+            for(u32 Column = 0; Column < HaversineColumn_Count; ++Column)
+            {
+                Range->Column[Column] = Columns->Column[Column] + FirstPair;
+            }
+        }
+        Range->SumCoef = SumCoef;
+        FirstPair += RangeCount;
+        
+        Threads[ThreadIndex] = std::thread(SumHaversineRange, Range);
+    }
+    
+    f64 Sum = 0;
+    for(u32 ThreadIndex = 0; ThreadIndex < SUM_THREAD_COUNT; ++ThreadIndex)
+    {
+        Threads[ThreadIndex].join();
+        Sum += Ranges[ThreadIndex].Sum;
+        
+        if(Answers && Validation)
+        {
+            MergeValidation(Validation, &Ranges[ThreadIndex].Validation);
+        }
+    }
+    
+    return Sum;
+}
+
+/* NOTE: With a block checksum file, the sum is computed block by block instead, with the
+   blocks dealt out round-robin to the threads. Each block is summed in pair order and the
+   block sums are added in block order, which is exactly how the generator accumulated them,
+   so an exact input reproduces the expected sum bit for bit. For JSON inputs each thread
+   also hashes the text of its blocks' pair objects. */
+/* NOTE: The JSON parser from listing 94 is not correctly rounded, so coordinates read from
+   text can be off by a few thousand ULPs and the block sums come out slightly different from
+   the generator's. Each pair's error carries into its block sum at roughly the same number of
+   the sum's ULPs, and summing the block can add up to another ULP per pair, so JSON block sums
+   are allowed this many ULPs plus one per pair. Binary inputs hold the generator's exact
+   values and have to match bit for bit. */
+#define JSON_BLOCK_SUM_ULP_ALLOWANCE 65536
+
+struct haversine_block_check
+{
+    haversine_checksum_header *Header;
+    haversine_block_checksum *Expected;
+    
+    f64 *BlockSums;
+    u64 *TextHashes;
+    b32 TextChecked;
+    b32 ExactSums;
+};
+
+struct haversine_block_range
+{
+    u32 ThreadIndex;
+    u64 PairCount;
+    haversine_pair *Pairs;
+    f64 *Column[HaversineColumn_Count];
+    buffer Text;
+    u64 *BlockTextStarts; // NOTE: 0 when there is no text to hash
+    f64 SumCoef;
+    haversine_block_check *Check;
+};
+
+static b32 GetBlockChecksums(buffer File, haversine_block_check *Check)
+{
+    *Check = {};
+    
+    if(File.Count < sizeof(haversine_checksum_header))
+    {
+        return false;
+    }
+    
+    haversine_checksum_header *Header = (haversine_checksum_header *)File.Data;
+    if((Header->Magic != HAVERSINE_CHECKSUM_MAGIC) ||
+       (Header->BlockPairCount == 0) ||
+       (Header->BlockCount != (Header->PairCount + Header->BlockPairCount - 1) / Header->BlockPairCount) ||
+       (File.Count < sizeof(haversine_checksum_header) + Header->BlockCount*sizeof(haversine_block_checksum)))
+    {
+        return false;
+    }
+    
+    Check->Header = Header;
+    Check->Expected = (haversine_block_checksum *)(Header + 1);
+    
+    return true;
+}
+
+/* NOTE: Finding where a block starts means counting the objects in front of it, so this
+   one pass is sequential. It only looks for '{', which memchr does at memory speed. The
+   first '{' opens the outer object, every following one opens a pair. */
+static b32 FindBlockTextStarts(buffer Text, u64 PairCount, u64 BlockPairCount, u64 *Starts)
+{
+    TimeBandwidth(__func__, Text.Count);
+    
+    u8 *End = Text.Data + Text.Count;
+    u8 *At = (u8 *)memchr(Text.Data, '{', Text.Count);
+    if(!At)
+    {
+        return false;
+    }
+    ++At;
+    
+    for(u64 PairIndex = 0; PairIndex < PairCount; ++PairIndex)
+    {
+        u8 *Open = (u8 *)memchr(At, '{', End - At);
+        if(!Open)
+        {
+            return false;
+        }
+        
+        if((PairIndex % BlockPairCount) == 0)
+        {
+            Starts[PairIndex / BlockPairCount] = Open - Text.Data;
+        }
+        
+        At = Open + 1;
+    }
+    
+    return true;
+}
+
+static u64 HashBlockText(buffer Text, u64 Start, u64 PairCount)
+{
+    u64 Hash = HAVERSINE_CHECKSUM_HASH_SEED;
+    
+    u8 *End = Text.Data + Text.Count;
+    u8 *At = Text.Data + Start;
+    for(u64 PairIndex = 0; PairIndex < PairCount; ++PairIndex)
+    {
+        u8 *Open = (u8 *)memchr(At, '{', End - At);
+        u8 *Close = Open ? (u8 *)memchr(Open, '}', End - Open) : 0;
+        if(!Close)
+        {
+            break;
+        }
+        
+        Hash = HashBytes(Hash, Open, (Close + 1) - Open);
+        At = Close + 1;
+    }
+    
+    return Hash;
+}
+
+static void SumHaversineBlockRange(haversine_block_range *Range)
+{
+    TimeBandwidth(__func__, (Range->PairCount / SUM_THREAD_COUNT)*sizeof(haversine_pair));
+    
+    haversine_block_check *Check = Range->Check;
+    u64 BlockPairCount = Check->Header->BlockPairCount;
+    u64 BlockCount = Check->Header->BlockCount;
+    f64 EarthRadius = 6372.8;
+    
+    for(u64 BlockIndex = Range->ThreadIndex; BlockIndex < BlockCount; BlockIndex += SUM_THREAD_COUNT)
+    {
+        u64 FirstPair = BlockIndex*BlockPairCount;
+        u64 OnePastLastPair = FirstPair + BlockPairCount;
+        if(OnePastLastPair > Range->PairCount)
+        {
+            OnePastLastPair = Range->PairCount;
+        }
+        
+        f64 Sum = 0;
+        for(u64 PairIndex = FirstPair; PairIndex < OnePastLastPair; ++PairIndex)
+        {
+            f64 Dist;
+            if(Range->Pairs)
+            {
+                haversine_pair Pair = Range->Pairs[PairIndex];
+                Dist = ReferenceHaversine(Pair.X0, Pair.Y0, Pair.X1, Pair.Y1, EarthRadius);
+            }
+            else
+            {
+                Dist = ReferenceHaversine(Range->Column[HaversineColumn_X0][PairIndex], Range->Column[HaversineColumn_Y0][PairIndex],
+                                          Range->Column[HaversineColumn_X1][PairIndex], Range->Column[HaversineColumn_Y1][PairIndex],
+                                          EarthRadius);
+            }
+            Sum += Range->SumCoef*Dist;
+        }
+        Check->BlockSums[BlockIndex] = Sum;
+        
+        if(Range->BlockTextStarts)
+        {
+            Check->TextHashes[BlockIndex] = HashBlockText(Range->Text, Range->BlockTextStarts[BlockIndex],
+                                                          OnePastLastPair - FirstPair);
+        }
+    }
+}
+
+// NOTE: Pass either Pairs or Columns, the other one has to be 0. Text is empty for binary inputs.
+static f64 SumHaversineBlocks(u64 PairCount, haversine_pair *Pairs, haversine_columns *Columns,
+                              buffer Text, haversine_block_check *Check)
+{
+    TimeFunction;
+    
+    u64 BlockCount = Check->Header->BlockCount;
+    Check->BlockSums = (f64 *)calloc(BlockCount + 1, sizeof(f64));
+    Check->TextHashes = (u64 *)calloc(BlockCount + 1, sizeof(u64));
+    
+    u64 *BlockTextStarts = 0;
+    if(Text.Count)
+    {
+        BlockTextStarts = (u64 *)calloc(BlockCount + 1, sizeof(u64));
+        Check->TextChecked = FindBlockTextStarts(Text, PairCount, Check->Header->BlockPairCount, BlockTextStarts);
+        if(!Check->TextChecked)
+        {
+            free(BlockTextStarts);
+            BlockTextStarts = 0;
+        }
+    }
+    
+    haversine_block_range Ranges[SUM_THREAD_COUNT] = {};
+    std::thread Threads[SUM_THREAD_COUNT];
+    for(u32 ThreadIndex = 0; ThreadIndex < SUM_THREAD_COUNT; ++ThreadIndex)
+    {
+        haversine_block_range *Range = Ranges + ThreadIndex;
+        Range->ThreadIndex = ThreadIndex;
+        Range->PairCount = PairCount;
+        Range->Pairs = Pairs;
+        if(Columns)
+        {
+            for(u32 Column = 0; Column < HaversineColumn_Count; ++Column)
+            {
+                Range->Column[Column] = Columns->Column[Column];
+            }
+        }
+        Range->Text = Text;
+        Range->BlockTextStarts = BlockTextStarts;
+        Range->SumCoef = 1 / (f64)PairCount;
+        Range->Check = Check;
+        
+        Threads[ThreadIndex] = std::thread(SumHaversineBlockRange, Range);
+    }
+    
+    for(u32 ThreadIndex = 0; ThreadIndex < SUM_THREAD_COUNT; ++ThreadIndex)
+    {
+        Threads[ThreadIndex].join();
+    }
+    
+    f64 Sum = 0;
+    for(u64 BlockIndex = 0; BlockIndex < BlockCount; ++BlockIndex)
+    {
+        Sum += Check->BlockSums[BlockIndex];
+    }
+    
+    free(BlockTextStarts);
+    
+    return Sum;
+}
+
+static void PrintBlockCheck(haversine_block_check *Check)
+{
+    haversine_checksum_header *Header = Check->Header;
+    
+    u64 AllowedULPs = Check->ExactSums ? 0 : (JSON_BLOCK_SUM_ULP_ALLOWANCE + Header->BlockPairCount);
+    
+    u64 MaxSumULPs = 0;
+    u64 SumMismatchCount = 0;
+    u64 FirstSumMismatch = 0;
+    u64 TextMismatchCount = 0;
+    u64 FirstTextMismatch = 0;
+    for(u64 BlockIndex = 0; BlockIndex < Header->BlockCount; ++BlockIndex)
+    {
+        haversine_block_checksum *Expected = Check->Expected + BlockIndex;
+        u64 SumULPs = ULPDistance(Check->BlockSums[BlockIndex], Expected->Sum);
+        if(MaxSumULPs < SumULPs)
+        {
+            MaxSumULPs = SumULPs;
+        }
+        
+        if(SumULPs > AllowedULPs)
+        {
+            if(SumMismatchCount++ == 0)
+            {
+                FirstSumMismatch = BlockIndex;
+            }
+        }
+        
+        if(Check->TextChecked && (Check->TextHashes[BlockIndex] != Expected->TextHash))
+        {
+            if(TextMismatchCount++ == 0)
+            {
+                FirstTextMismatch = BlockIndex;
+            }
+        }
+    }
+    
+    fprintf(stdout, "Blocks checked: %llu of %llu pairs\n", Header->BlockCount, Header->BlockPairCount);
+    
+    if(!Check->TextChecked)
+    {
+        fprintf(stdout, "Text hashes: not checked\n");
+    }
+    else if(TextMismatchCount)
+    {
+        fprintf(stdout, "Text hash mismatches: %llu (first at block %llu, pairs %llu and up)\n",
+                TextMismatchCount, FirstTextMismatch, FirstTextMismatch*Header->BlockPairCount);
+    }
+    else
+    {
+        fprintf(stdout, "Text hashes: all match\n");
+    }
+    
+    if(SumMismatchCount)
+    {
+        fprintf(stdout, "Block sum mismatches: %llu over %llu ULPs (first at block %llu: %.16f, reference %.16f)\n",
+                SumMismatchCount, AllowedULPs, FirstSumMismatch,
+                Check->BlockSums[FirstSumMismatch], Check->Expected[FirstSumMismatch].Sum);
+    }
+    else if(Check->ExactSums)
+    {
+        fprintf(stdout, "Block sums: all match bit for bit\n");
+    }
+    else
+    {
+        fprintf(stdout, "Block sums: all within %llu ULPs (max %llu)\n", AllowedULPs, MaxSumULPs);
+    }
+}
+
+// NOTE: Pass Check to validate block by block, otherwise Answers are checked pair by pair if they line up
+static f64 SumHaversineJSON(char *FileName, u64 *InputSize, u64 *PairCount,
+                            buffer Answers, haversine_validation *Validation, haversine_block_check *Check)
+{
+    f64 Sum = 0;
+    
+    buffer InputJSON = ReadEntireFile(FileName);
+    *InputSize = InputJSON.Count;
+    
+    u32 MinimumJSONPairEncoding = 6*4;
+    u64 MaxPairCount = InputJSON.Count / MinimumJSONPairEncoding;
+    if(MaxPairCount)
+    {
+        buffer ParsedValues = AllocateBuffer(MaxPairCount * sizeof(haversine_pair));
+        if(ParsedValues.Count)
+        {
+            haversine_pair *Pairs = (haversine_pair *)ParsedValues.Data;
+            
+            {
+                TimeBandwidth("Parse", InputJSON.Count);
+                *PairCount = ParseHaversinePairs(InputJSON, MaxPairCount, Pairs);
+            }
+            
+            /* NOTE: The pair count is only known after parsing. If it does not match the answer
+               file, the pairs cannot be lined up with their answers and only the sum is checked. */
+            if(Check && (Check->Header->PairCount == *PairCount))
+            {
+                Sum = SumHaversineBlocks(*PairCount, Pairs, 0, InputJSON, Check);
+            }
+            else
+            {
+                f64 *AnswerValues = 0;
+                if(Answers.Count == (*PairCount + 1)*sizeof(f64))
+                {
+                    AnswerValues = (f64 *)Answers.Data;
+                }
+                Sum = SumHaversineDistances(*PairCount, Pairs, 0, AnswerValues, Validation);
+            }
+        }
+        
+        FreeBuffer(&ParsedValues);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Malformed input JSON\n");
+    }
+    
+    FreeBuffer(&InputJSON);
+    
+    return Sum;
+}
+
+int main(int ArgCount, char **Args)
+{
+    BeginProfile();
+	
+    int Result = 1;
+    
+    if((ArgCount == 2) || (ArgCount == 3))
+    {
+        u64 InputSize = 0;
+        u64 PairCount = 0;
+        f64 Sum = 0;
+        
+        /* NOTE: The answers are mapped, not read. Only the pages the validation is currently
+           walking through have to be resident, next to the inputs. The second file can also
+           be a block checksum file, which is recognized by its header. */
+        buffer AnswersF64 = {};
+        if(ArgCount == 3)
+        {
+            TimeBlock("Map answers");
+            AnswersF64 = MapEntireFile(Args[2]);
+        }
+        
+        u64 RefAnswerCount = 0;
+        if(AnswersF64.Count >= sizeof(f64))
+        {
+            RefAnswerCount = (AnswersF64.Count - sizeof(f64)) / sizeof(f64);
+        }
+        
+        haversine_validation Validation = {};
+        
+        haversine_block_check BlockCheck = {};
+        b32 CheckBlocks = GetBlockChecksums(AnswersF64, &BlockCheck);
+        if(CheckBlocks)
+        {
+            RefAnswerCount = BlockCheck.Header->PairCount;
+        }
+        
+        /* NOTE: Binary inputs are recognized by their header and summed straight out of the
+           mapping. Anything else gets read and parsed as JSON like before. */
+        buffer InputMapping = {};
+        {
+            TimeBlock("Map input");
+            InputMapping = MapEntireFile(Args[1]);
+        }
+        
+        haversine_columns Columns = {};
+        if(GetHaversineColumns(InputMapping, &Columns))
+        {
+            InputSize = InputMapping.Count;
+            PairCount = Columns.PairCount;
+            
+            if(CheckBlocks && (RefAnswerCount == PairCount))
+            {
+                buffer NoText = {};
+                BlockCheck.ExactSums = true;
+                Sum = SumHaversineBlocks(PairCount, 0, &Columns, NoText, &BlockCheck);
+            }
+            else
+            {
+                f64 *AnswerValues = (!CheckBlocks && (RefAnswerCount == PairCount)) ? (f64 *)AnswersF64.Data : 0;
+                Sum = SumHaversineDistances(PairCount, 0, &Columns, AnswerValues, &Validation);
+            }
+            
+            haversine_binary_header *Header = (haversine_binary_header *)InputMapping.Data;
+            fprintf(stdout, "Binary input, seed %llu, expected sum %.16f\n", Header->Seed, Header->ExpectedSum);
+        }
+        else if(InputMapping.Data)
+        {
+            UnmapFile(&InputMapping);
+            Sum = SumHaversineJSON(Args[1], &InputSize, &PairCount, CheckBlocks ? buffer{} : AnswersF64,
+                                   &Validation, CheckBlocks ? &BlockCheck : 0);
+        }
+        
+        if(PairCount)
+        {
+            Result = 0;
+            
+            fprintf(stdout, "Input size: %llu\n", InputSize);
+            fprintf(stdout, "Pair count: %llu\n", PairCount);
+            fprintf(stdout, "Haversine sum: %.16f\n", Sum);
+            
+            if(AnswersF64.Count >= sizeof(f64))
+            {
+                fprintf(stdout, "\nValidation:\n");
+                
+                if(PairCount != RefAnswerCount)
+                {
+                    fprintf(stdout, "FAILED - pair count doesn't match %llu.\n", RefAnswerCount);
+                }
+                else if(CheckBlocks)
+                {
+                    PrintBlockCheck(&BlockCheck);
+                }
+                else
+                {
+                    PrintValidation(&Validation, PairCount);
+                }
+                
+                f64 RefSum = CheckBlocks ? BlockCheck.Header->ExpectedSum : ((f64 *)AnswersF64.Data)[RefAnswerCount];
+                fprintf(stdout, "Reference sum: %.16f\n", RefSum);
+                fprintf(stdout, "Difference: %.16f\n", Sum - RefSum);
+                
+                fprintf(stdout, "\n");
+            }
+        }
+        
+        free(BlockCheck.BlockSums);
+        free(BlockCheck.TextHashes);
+        UnmapFile(&InputMapping);
+        UnmapFile(&AnswersF64);
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s [haversine_input.json or .bin]\n", Args[0]);
+        fprintf(stderr, "       %s [haversine_input.json or .bin] [answers.f64 or blocks.bin]\n", Args[0]);
+    }
+
+    if(Result == 0)
+	{
+        EndAndPrintProfile();
+	}
+		
+    return Result;
+}
@@ -7,6 +7,8 @@ call clang -g -fuse-ld=lld ..\sim86.cpp -o sim86_clang_debug.exe
 call cl -O2 -nologo -Zi -FC ..\sim86.cpp -Fesim86_msvc_release.exe
 call clang -O3 -g -fuse-ld=lld ..\sim86.cpp -o sim86_clang_release.exe
 
+call cl -nologo -Zi -FC ..\sim86_clocks_test.cpp -Fesim86_clocks_test.exe
+
 call clang -P -E ..\sim86_lib.h | call clang-format --style="Microsoft" > ..\shared\sim86_shared.h
 call clang -P -E ..\sim86_instruction_table_standalone.h | call clang-format --style="Microsoft" > sim86_instruction_table_standalone.h
 
@@ -34,6 +34,7 @@
 #include "sim86_execute.h"
 #include "sim86_cycles.h"
 #include "sim86_text.h"
+#include "sim86_profile.h"
 
 #include "sim86_instruction.cpp"
 #include "sim86_instruction_table.cpp"
@@ -43,6 +44,7 @@
 #include "sim86_cycles.cpp"
 #include "sim86_text_table.cpp"
 #include "sim86_text.cpp"
+#include "sim86_profile.cpp"
 
 enum sim_flags
 {
@@ -51,6 +53,8 @@ enum sim_flags
     SimFlag_DumpMemory = 0x4,
     SimFlag_ExplainClocks = 0x8,
     SimFlag_NoRegisterDiffs = 0x10,
+    SimFlag_Profile = 0x20,
+    SimFlag_Pipeline = 0x40,
 };
 
 static u32 LoadMemoryFromFile(char *FileName, segmented_access SegMem, u32 AtOffset)
@@ -93,10 +97,10 @@ static segmented_access AllocateMemoryPow2(u32 SizePow2)
     return Result;
 }
 
-static void PrintEstimatedClocks(timing_state State, instruction Instruction, u32 SimFlags,
-                                 instruction_clock_interval *Accum)
+static void PrintEstimatedClocks(instruction_clock_table ClockTable, timing_state State, instruction Instruction,
+                                 u32 SimFlags, instruction_clock_interval *Accum, pipeline_state *Pipeline)
 {
-    instruction_timing Timing = EstimateInstructionClocks(State, Instruction);
+    instruction_timing Timing = LookupInstructionClocks(ClockTable, State, Instruction);
     instruction_clock_interval Clocks = ExpectedClocksFrom(State, Instruction, Timing);
     Accum->Min += Clocks.Min;
     Accum->Max += Clocks.Max;
@@ -114,6 +118,33 @@ static void PrintEstimatedClocks(timing_state State, instruction Instruction, u3
     {
         ExplainTiming(Timing, Clocks, stdout);
     }
+    
+    if(Pipeline)
+    {
+        u32 StallClocks = Pipeline->Queue[0].StallClocks;
+        instruction_clock_interval PipelineClocks = PipelineClocksFrom(Pipeline, State, Instruction, Timing, Clocks);
+        
+        fprintf(stdout, " | Pipeline: +");
+        PrintClockInterval(PipelineClocks, stdout);
+        fprintf(stdout, " = ");
+        PrintClockInterval(Pipeline->Total, stdout);
+        
+        StallClocks = Pipeline->Queue[0].StallClocks - StallClocks;
+        if((SimFlags & SimFlag_ExplainClocks) && StallClocks)
+        {
+            fprintf(stdout, " (%u stalled)", StallClocks);
+        }
+    }
+}
+
+static void PrintClockTotals(instruction_clock_interval TimeAccum, pipeline_state *Pipeline)
+{
+    fprintf(stdout, "Total clocks: ");
+    PrintClockInterval(TimeAccum, stdout);
+    fprintf(stdout, " from the manual, ");
+    PrintClockInterval(Pipeline->Total, stdout);
+    fprintf(stdout, " with the %u-byte prefetch queue (%u waiting on the BIU)\n",
+            Pipeline->QueueSize, Pipeline->Queue[0].StallClocks);
 }
 
 static void DisAsm8086(u32 DisAsmByteCount, segmented_access DisAsmStart, u32 SimFlags, timing_state Timing)
@@ -121,12 +152,16 @@ static void DisAsm8086(u32 DisAsmByteCount, segmented_access DisAsmStart, u32 Si
     segmented_access At = DisAsmStart;
     
     instruction_table Table = Get8086InstructionTable();
+    instruction_clock_table ClockTable = Get8086ClockTable();
 
     // NOTE(casey): When not simulating, assume branches are taken, since that is what most loop conditionals will do
     // and that is what we would normally be timing.
     Timing.AssumeBranchTaken = true;
     instruction_clock_interval TimeAccum = {};
     
+    pipeline_state PipelineState = InitPipeline(Timing);
+    pipeline_state *Pipeline = (SimFlags & SimFlag_Pipeline) ? &PipelineState : 0;
+    
     u32 Count = DisAsmByteCount;
     while(Count)
     {
@@ -148,7 +183,7 @@ static void DisAsm8086(u32 DisAsmByteCount, segmented_access DisAsmStart, u32 Si
             if(SimFlags & SimFlag_ShowClocks)
             {
                 printf(" ; ");
-                PrintEstimatedClocks(Timing, Instruction, SimFlags, &TimeAccum);
+                PrintEstimatedClocks(ClockTable, Timing, Instruction, SimFlags, &TimeAccum, Pipeline);
             }
             printf("\n");
         }
@@ -158,6 +193,12 @@ static void DisAsm8086(u32 DisAsmByteCount, segmented_access DisAsmStart, u32 Si
             break;
         }
     }
+    
+    if(Pipeline)
+    {
+        printf("; ");
+        PrintClockTotals(TimeAccum, Pipeline);
+    }
 }
 
 static b32 IsRet(operation_type Op)
@@ -170,9 +211,20 @@ static b32 IsRet(operation_type Op)
 static void Run8086(u32 OnePastLastByte, segmented_access MainMemory, u32 SimFlags, timing_state Timing)
 {
     instruction_table Table = Get8086InstructionTable();
+    instruction_clock_table ClockTable = Get8086ClockTable();
     register_state_8086 Registers = {};
+    lazy_flags Flags = {};
     instruction_clock_interval TimeAccum = {};
     
+    pipeline_state PipelineState = InitPipeline(Timing);
+    pipeline_state *Pipeline = (SimFlags & SimFlag_Pipeline) ? &PipelineState : 0;
+    
+    profile Profile = {};
+    if(SimFlags & SimFlag_Profile)
+    {
+        Profile = AllocateProfile(GetHighestAddress(MainMemory) + 1, 1 << 16);
+    }
+    
     for(;;)
     {
         segmented_access At = MainMemory;
@@ -195,29 +247,48 @@ static void Run8086(u32 OnePastLastByte, segmented_access MainMemory, u32 SimFla
                 }
                 
                 Registers.ip += Instruction.Size;
-                exec_result Exec = ExecInstruction(MainMemory, &Registers, Instruction);
+                exec_result Exec = ExecInstruction(MainMemory, &Registers, &Flags, Instruction);
                 
-                if(!Exec.Unimplemented)
+                if(Exec.Unimplemented)
+                {
+                    printf("ERROR: Unimplemented instruction (%s).\n", GetMnemonic(Instruction.Op));
+                    break;
+                }
+                else if(SimFlags & SimFlag_Profile)
+                {
+                    // NOTE: Profiling replaces the per-instruction trace, since the point is
+                    // to be able to run programs that are far too long to read instruction by instruction.
+                    UpdateTimingForExec(&Timing, Exec);
+                    instruction_timing InstructionTiming = LookupInstructionClocks(ClockTable, Timing, Instruction);
+                    instruction_clock_interval Clocks = ExpectedClocksFrom(Timing, Instruction, InstructionTiming);
+                    TimeAccum.Min += Clocks.Min;
+                    TimeAccum.Max += Clocks.Max;
+                    
+                    // NOTE: With -pipeline, the profile attributes the prefetch queue clocks instead
+                    // of the manual ones, so its total matches the pipeline total.
+                    if(Pipeline)
+                    {
+                        Clocks = PipelineClocksFrom(Pipeline, Timing, Instruction, InstructionTiming, Clocks);
+                    }
+                    ProfileInstruction(&Profile, Instruction, Clocks);
+                }
+                else
                 {
                     PrintInstruction(Instruction, stdout);
                     printf(" ; ");
                     if(SimFlags & SimFlag_ShowClocks)
                     {
                         UpdateTimingForExec(&Timing, Exec);
-                        PrintEstimatedClocks(Timing, Instruction, SimFlags, &TimeAccum);
+                        PrintEstimatedClocks(ClockTable, Timing, Instruction, SimFlags, &TimeAccum, Pipeline);
                         fprintf(stdout, " | ");
                     }
                     if(!(SimFlags & SimFlag_NoRegisterDiffs))
                     {
+                        MaterializeFlags(&Registers, &Flags);
                         PrintRegisterDifference(&PrevRegisters, &Registers, stdout);
                     }
                     printf("\n");
                 }
-                else
-                {
-                    printf("ERROR: Unimplemented instruction (%s).\n", GetMnemonic(Instruction.Op));
-                    break;
-                }
             }
             else
             {
@@ -232,9 +303,21 @@ static void Run8086(u32 OnePastLastByte, segmented_access MainMemory, u32 SimFla
     }
     
     printf("\n");
+    if(Pipeline)
+    {
+        PrintClockTotals(TimeAccum, Pipeline);
+        printf("\n");
+    }
     printf("Final registers:\n");
+    MaterializeFlags(&Registers, &Flags);
     PrintRegisters(&Registers, stdout);
     printf("\n");
+    
+    if(SimFlags & SimFlag_Profile)
+    {
+        PrintProfile(&Profile, stdout);
+        FreeProfile(&Profile);
+    }
 }
 
 int main(int ArgCount, char **Args)
@@ -284,9 +367,18 @@ int main(int ArgCount, char **Args)
                 {
                     SimFlags |= SimFlag_StopOnRet;
                 }
+                else if(strcmp(FileName, "-pipeline") == 0)
+                {
+                    SimFlags |= SimFlag_ShowClocks|SimFlag_Pipeline;
+                }
+                else if(strcmp(FileName, "-profile") == 0)
+                {
+                    Execute = true;
+                    SimFlags |= SimFlag_Profile;
+                }
                 else
                 {
-                    if(SimFlags & SimFlag_ShowClocks)
+                    if(SimFlags & (SimFlag_ShowClocks|SimFlag_Profile))
                     {
                         fprintf(stdout,
                                 "\n"
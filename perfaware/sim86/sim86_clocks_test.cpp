@@ -0,0 +1,150 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+/* NOTE: Checks that the precomputed clock table gives exactly the same timings as the reference
+   switch in EstimateInstructionClocks. Every one and two byte opcode/mod-reg-r/m combination is decoded,
+   with and without each kind of prefix and with both zero and non-zero displacements/data following it,
+   and each instruction that decodes is timed under a spread of timing states. */
+
+#include "sim86.h"
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "sim86_instruction.h"
+#include "sim86_instruction_table.h"
+#include "sim86_memory.h"
+#include "sim86_decode.h"
+#include "sim86_execute.h"
+#include "sim86_cycles.h"
+#include "sim86_text.h"
+
+#include "sim86_instruction.cpp"
+#include "sim86_instruction_table.cpp"
+#include "sim86_memory.cpp"
+#include "sim86_decode.cpp"
+#include "sim86_execute.cpp"
+#include "sim86_cycles.cpp"
+#include "sim86_text_table.cpp"
+#include "sim86_text.cpp"
+
+static void PrintTiming(instruction_timing Timing, FILE *Dest)
+{
+    fprintf(Dest, "[%u,%u] %ut %uea", Timing.Base.Min, Timing.Base.Max, Timing.Transfers, Timing.EAClocks);
+}
+
+int main(void)
+{
+    u8 const Prefixes[] = {0x00, 0xf0, 0xf2, 0xf3, 0x26, 0x2e, 0x36, 0x3e};
+    u8 const Trailers[][4] =
+    {
+        {0x00, 0x00, 0x00, 0x00},
+        {0x03, 0x81, 0x7f, 0x80},
+    };
+    u32 const RepCounts[] = {0, 1, 2, 7, 65535};
+    u32 const ShiftCounts[] = {0, 1, 5, 255};
+
+    instruction_table Table = Get8086InstructionTable();
+    instruction_clock_table ClockTable = Get8086ClockTable();
+
+    u32 DecodeCount = 0;
+    u32 CheckCount = 0;
+    u32 MismatchCount = 0;
+    b32 OpSeen[Op_Count] = {};
+
+    u8 Bytes[32] = {};
+    segmented_access At = FixedMemoryPow2(5, Bytes);
+
+    for(u32 PrefixIndex = 0; PrefixIndex < ArrayCount(Prefixes); ++PrefixIndex)
+    {
+        for(u32 TrailerIndex = 0; TrailerIndex < ArrayCount(Trailers); ++TrailerIndex)
+        {
+            for(u32 Pair = 0; Pair < 0x10000; ++Pair)
+            {
+                memset(Bytes, 0, sizeof(Bytes));
+
+                u32 Count = 0;
+                if(Prefixes[PrefixIndex])
+                {
+                    Bytes[Count++] = Prefixes[PrefixIndex];
+                }
+                Bytes[Count++] = (u8)(Pair >> 8);
+                Bytes[Count++] = (u8)(Pair & 0xff);
+                for(u32 TrailerByte = 0; TrailerByte < ArrayCount(Trailers[TrailerIndex]); ++TrailerByte)
+                {
+                    Bytes[Count++] = Trailers[TrailerIndex][TrailerByte];
+                }
+
+                instruction Instruction = DecodeInstruction(Table, At);
+                if(Instruction.Op)
+                {
+                    ++DecodeCount;
+                    OpSeen[Instruction.Op] = true;
+
+                    for(u32 Taken = 0; Taken < 2; ++Taken)
+                    {
+                        for(u32 RepIndex = 0; RepIndex < ArrayCount(RepCounts); ++RepIndex)
+                        {
+                            for(u32 ShiftIndex = 0; ShiftIndex < ArrayCount(ShiftCounts); ++ShiftIndex)
+                            {
+                                timing_state State = {};
+                                State.AssumeBranchTaken = Taken;
+                                State.AssumeRepCount = RepCounts[RepIndex];
+                                State.AssumeShiftCount = ShiftCounts[ShiftIndex];
+
+                                instruction_timing Expected = EstimateInstructionClocks(State, Instruction);
+                                instruction_timing Actual = LookupInstructionClocks(ClockTable, State, Instruction);
+                                ++CheckCount;
+
+                                if(!TimingsMatch(Expected, Actual))
+                                {
+                                    if(MismatchCount < 16)
+                                    {
+                                        fprintf(stdout, "MISMATCH: ");
+                                        PrintInstruction(Instruction, stdout);
+                                        fprintf(stdout, " (taken %u, rep %u, shift %u): expected ",
+                                                Taken, State.AssumeRepCount, State.AssumeShiftCount);
+                                        PrintTiming(Expected, stdout);
+                                        fprintf(stdout, ", table ");
+                                        PrintTiming(Actual, stdout);
+                                        fprintf(stdout, "\n");
+                                    }
+
+                                    ++MismatchCount;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    u32 OpCount = 0;
+    for(u32 Op = 1; Op < Op_Count; ++Op)
+    {
+        if(OpSeen[Op])
+        {
+            ++OpCount;
+        }
+    }
+
+    fprintf(stdout, "Decoded %u instructions covering %u of %u ops, %u timings checked, %u mismatches.\n",
+            DecodeCount, OpCount, Op_Count - 1, CheckCount, MismatchCount);
+
+    int Result = (MismatchCount ? 1 : 0);
+    return Result;
+}
@@ -480,6 +480,197 @@ static instruction_timing EstimateInstructionClocks(timing_state State, instruct
     return Result;
 }
 
+/* NOTE: EstimateInstructionClocks is the reference transcription of the manual's table, but it is
+   a lot of branching to go through for every simulated instruction. Other than the effective address and
+   the timing state, everything it looks at is part of the instruction's shape (the op, the two operand
+   types, and whether it is wide or far), so the table below is filled in once by running the switch on a
+   representative instruction of every shape. The ways the result still depends on the timing state are
+   recorded as one of a handful of rules, and the effective address is added on at lookup time. */
+
+static u32 const ClockShapeCount = 4*4*2*2;
+static instruction_clock_entry ClockTable8086[Op_Count*ClockShapeCount];
+
+static u32 ClockTableIndex(operation_type Op, operand_type Type0, operand_type Type1, u32 Flags)
+{
+    u32 Result = Op;
+    Result = 4*Result + Type0;
+    Result = 4*Result + Type1;
+    Result = 2*Result + ((Flags & Inst_Wide) ? 1 : 0);
+    Result = 2*Result + ((Flags & Inst_Far) ? 1 : 0);
+    
+    return Result;
+}
+
+static b32 TimingsMatch(instruction_timing A, instruction_timing B)
+{
+    b32 Result = ((A.Base.Min == B.Base.Min) &&
+                  (A.Base.Max == B.Base.Max) &&
+                  (A.Transfers == B.Transfers) &&
+                  (A.EAClocks == B.EAClocks));
+    return Result;
+}
+
+static instruction_clock_entry BuildClockEntry(instruction Instruction)
+{
+    timing_state State = {};
+    instruction_timing Timing = EstimateInstructionClocks(State, Instruction);
+    
+    instruction_clock_entry Result = {};
+    Result.Min = (u16)Timing.Base.Min;
+    Result.Max = (u16)Timing.Base.Max;
+    Result.Transfers = (u8)Timing.Transfers;
+    Result.UsesEA = (Timing.EAClocks != 0);
+    
+    timing_state TakenState = State;
+    TakenState.AssumeBranchTaken = true;
+    instruction_timing Taken = EstimateInstructionClocks(TakenState, Instruction);
+    
+    // NOTE: Two repetition counts are needed to separate the per-repetition cost from the setup cost
+    timing_state Rep1State = State;
+    Rep1State.AssumeRepCount = 1;
+    instruction_timing Rep1 = EstimateInstructionClocks(Rep1State, Instruction);
+    
+    timing_state Rep2State = State;
+    Rep2State.AssumeRepCount = 2;
+    instruction_timing Rep2 = EstimateInstructionClocks(Rep2State, Instruction);
+    
+    timing_state ShiftState = State;
+    ShiftState.AssumeShiftCount = 1;
+    instruction_timing Shift = EstimateInstructionClocks(ShiftState, Instruction);
+    
+    instruction_timing Int3 = Timing;
+    if(OperandIsType(Instruction, 0, Operand_Immediate))
+    {
+        instruction Int3Instruction = Instruction;
+        Int3Instruction.Operands[0].Immediate.Value = 3;
+        Int3 = EstimateInstructionClocks(State, Int3Instruction);
+    }
+    
+    if(!TimingsMatch(Taken, Timing))
+    {
+        Result.Rule = ClockRule_Taken;
+        Result.Alternate = (u16)Taken.Base.Min;
+        Result.AlternateTransfers = (u8)Taken.Transfers;
+    }
+    else if(!TimingsMatch(Int3, Timing))
+    {
+        Result.Rule = ClockRule_Int3;
+        Result.Alternate = (u16)Int3.Base.Min;
+        Result.AlternateTransfers = (u8)Int3.Transfers;
+    }
+    else if(!TimingsMatch(Rep1, Timing))
+    {
+        Result.Rule = ClockRule_Rep;
+        Result.PerCountClocks = (u8)(Rep2.Base.Min - Rep1.Base.Min);
+        Result.PerCountTransfers = (u8)(Rep2.Transfers - Rep1.Transfers);
+        Result.Alternate = (u16)(Rep1.Base.Min - Result.PerCountClocks);
+        Result.AlternateTransfers = (u8)(Rep1.Transfers - Result.PerCountTransfers);
+    }
+    else if(!TimingsMatch(Shift, Timing))
+    {
+        Result.Rule = ClockRule_Shift;
+        Result.PerCountClocks = (u8)(Shift.Base.Min - Timing.Base.Min);
+        Result.PerCountTransfers = (u8)(Shift.Transfers - Timing.Transfers);
+    }
+    
+    return Result;
+}
+
+static instruction_clock_table Get8086ClockTable()
+{
+    static b32 Initialized;
+    if(!Initialized)
+    {
+        for(u32 Op = 0; Op < Op_Count; ++Op)
+        {
+            for(u32 Type0 = Operand_None; Type0 <= Operand_Immediate; ++Type0)
+            {
+                for(u32 Type1 = Operand_None; Type1 <= Operand_Immediate; ++Type1)
+                {
+                    for(u32 WideFar = 0; WideFar < 4; ++WideFar)
+                    {
+                        // NOTE: A memory operand with no registers and no displacement is enough
+                        // to tell whether the effective address is charged, since its EA is never 0.
+                        instruction Instruction = {};
+                        Instruction.Op = (operation_type)Op;
+                        Instruction.Flags = ((WideFar & 1) ? Inst_Wide : 0) | ((WideFar & 2) ? Inst_Far : 0);
+                        Instruction.Operands[0].Type = (operand_type)Type0;
+                        Instruction.Operands[1].Type = (operand_type)Type1;
+                        
+                        u32 Index = ClockTableIndex(Instruction.Op, Instruction.Operands[0].Type,
+                                                    Instruction.Operands[1].Type, Instruction.Flags);
+                        ClockTable8086[Index] = BuildClockEntry(Instruction);
+                    }
+                }
+            }
+        }
+        
+        Initialized = true;
+    }
+    
+    instruction_clock_table Result = {};
+    Result.Entries = ClockTable8086;
+    Result.EntryCount = ArrayCount(ClockTable8086);
+    
+    return Result;
+}
+
+static instruction_timing LookupInstructionClocks(instruction_clock_table Table, timing_state State, instruction Instruction)
+{
+    u32 Index = ClockTableIndex(Instruction.Op, Instruction.Operands[0].Type, Instruction.Operands[1].Type, Instruction.Flags);
+    assert(Index < Table.EntryCount);
+    instruction_clock_entry Entry = Table.Entries[Index];
+    
+    instruction_timing Result = ClockRangeTransfers(Entry.Min, Entry.Max, Entry.Transfers);
+    switch(Entry.Rule)
+    {
+        case ClockRule_Fixed:
+        {
+        } break;
+        
+        case ClockRule_Taken:
+        {
+            if(State.AssumeBranchTaken)
+            {
+                Result = ClocksTransfers(Entry.Alternate, Entry.AlternateTransfers);
+            }
+        } break;
+        
+        case ClockRule_Int3:
+        {
+            if(Instruction.Operands[0].Immediate.Value == 3)
+            {
+                Result = ClocksTransfers(Entry.Alternate, Entry.AlternateTransfers);
+            }
+        } break;
+        
+        case ClockRule_Rep:
+        {
+            u32 Rep = State.AssumeRepCount;
+            if(Rep)
+            {
+                Result = ClocksTransfers(Entry.Alternate + Entry.PerCountClocks*Rep,
+                                         Entry.AlternateTransfers + Entry.PerCountTransfers*Rep);
+            }
+        } break;
+        
+        case ClockRule_Shift:
+        {
+            u32 CL = State.AssumeShiftCount;
+            Result.Base.Min += Entry.PerCountClocks*CL;
+            Result.Base.Max += Entry.PerCountClocks*CL;
+            Result.Transfers += Entry.PerCountTransfers*CL;
+        } break;
+    }
+    
+    if(Entry.UsesEA)
+    {
+        Result.EAClocks = CalculateEAClocksFrom(Instruction, OperandIsType(Instruction, 1, Operand_Memory) ? 1 : 0);
+    }
+    
+    return Result;
+}
+
 static void UpdateTimingForExec(timing_state *State, exec_result Exec)
 {
     State->AssumeBranchTaken = Exec.BranchTaken;
@@ -503,3 +694,143 @@ static instruction_clock_interval ExpectedClocksFrom(timing_state State, instruc
     
     return Result;
 }
+
+/* NOTE: The manual's clocks assume the instruction bytes are already waiting in the prefetch queue,
+   which is rarely true for code that keeps the bus busy, especially on the 8088. This is a simple model of
+   the bus interface unit running alongside the execution unit:
+   
+   - The BIU fetches instruction bytes in 4-clock bus cycles whenever the bus is free and the queue has
+     room: one byte at a time on the 8088 (4-byte queue), and a word at a time on the 8086 (6-byte queue,
+     one byte when fetching from an odd address, and only once two bytes are free).
+   - The EU waits whenever the bytes of the next instruction are not in the queue yet.
+   - While the EU executes, the bus is free for prefetching except for the bus cycles the EU's own
+     memory transfers take, and those have to wait for a prefetch already in flight to finish.
+   - Any transfer of control (anything where the next instruction isn't the next byte in the queue)
+     empties the queue.
+   
+   It is still built on the manual's numbers, so it is only "more realistic", not accurate. */
+
+static u32 PrefetchWidth(pipeline_state *Pipeline, prefetch_queue *Queue)
+{
+    u32 Result = 1;
+    if(!Pipeline->ByteBus && !((Queue->StartAddress + Queue->ByteCount) & 1))
+    {
+        Result = 2;
+    }
+    
+    if(Result > (Pipeline->QueueSize - Queue->ByteCount))
+    {
+        Result = Pipeline->QueueSize - Queue->ByteCount;
+    }
+    
+    return Result;
+}
+
+static b32 CanPrefetch(pipeline_state *Pipeline, prefetch_queue *Queue)
+{
+    u32 Room = Pipeline->QueueSize - Queue->ByteCount;
+    b32 Result = (Room >= (Pipeline->ByteBus ? 1u : 2u));
+    return Result;
+}
+
+static u32 FinishPrefetch(pipeline_state *Pipeline, prefetch_queue *Queue)
+{
+    u32 Result = 4 - Queue->BusProgress;
+    Queue->ByteCount += PrefetchWidth(Pipeline, Queue);
+    Queue->BusProgress = 0;
+    
+    return Result;
+}
+
+static void RunPrefetch(pipeline_state *Pipeline, prefetch_queue *Queue, u32 FreeClocks)
+{
+    while(FreeClocks && (Queue->BusProgress || CanPrefetch(Pipeline, Queue)))
+    {
+        u32 Remaining = 4 - Queue->BusProgress;
+        if(FreeClocks >= Remaining)
+        {
+            FreeClocks -= FinishPrefetch(Pipeline, Queue);
+        }
+        else
+        {
+            Queue->BusProgress += FreeClocks;
+            FreeClocks = 0;
+        }
+    }
+}
+
+static u32 PipelineClocksForQueue(pipeline_state *Pipeline, prefetch_queue *Queue, instruction Instruction,
+                                  u32 EUClocks, u32 BusClocks)
+{
+    u32 Stall = 0;
+    
+    if(Instruction.Address != Queue->StartAddress)
+    {
+        Queue->StartAddress = Instruction.Address;
+        Queue->ByteCount = 0;
+        Queue->BusProgress = 0;
+    }
+    
+    // NOTE: On the 8088 an instruction can be longer than the whole queue, so bytes are taken as
+    // they arrive rather than waiting for the whole instruction to be queued.
+    u32 Needed = Instruction.Size;
+    for(;;)
+    {
+        u32 Take = (Queue->ByteCount < Needed) ? Queue->ByteCount : Needed;
+        Queue->ByteCount -= Take;
+        Queue->StartAddress += Take;
+        Needed -= Take;
+        
+        if(!Needed)
+        {
+            break;
+        }
+        
+        Stall += FinishPrefetch(Pipeline, Queue);
+    }
+    
+    if(BusClocks > EUClocks)
+    {
+        BusClocks = EUClocks;
+    }
+    
+    RunPrefetch(Pipeline, Queue, EUClocks - BusClocks);
+    if(BusClocks && Queue->BusProgress)
+    {
+        Stall += FinishPrefetch(Pipeline, Queue);
+    }
+    
+    Queue->StallClocks += Stall;
+    
+    u32 Result = EUClocks + Stall;
+    return Result;
+}
+
+static pipeline_state InitPipeline(timing_state State)
+{
+    pipeline_state Result = {};
+    
+    Result.ByteBus = State.Assume8088;
+    Result.QueueSize = State.Assume8088 ? 4 : 6;
+    
+    return Result;
+}
+
+static instruction_clock_interval PipelineClocksFrom(pipeline_state *Pipeline, timing_state State, instruction Instruction,
+                                                     instruction_timing Timing, instruction_clock_interval Clocks)
+{
+    u32 BusCycles = Timing.Transfers;
+    if((Instruction.Flags & Inst_Wide) && (State.Assume8088 || State.AssumeAddressUnanaligned))
+    {
+        BusCycles *= 2;
+    }
+    
+    instruction_clock_interval Result = {};
+    Result.Min = PipelineClocksForQueue(Pipeline, &Pipeline->Queue[0], Instruction, Clocks.Min, 4*BusCycles);
+    Result.Max = PipelineClocksForQueue(Pipeline, &Pipeline->Queue[1], Instruction, Clocks.Max, 4*BusCycles);
+    
+    Pipeline->Total.Min += Result.Min;
+    Pipeline->Total.Max += Result.Max;
+    
+    return Result;
+}
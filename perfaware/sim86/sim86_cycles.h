@@ -32,6 +32,59 @@ struct timing_state
     u32 AssumeShiftCount;
 };
 
+enum instruction_clock_rule : u8
+{
+    ClockRule_Fixed,
+    ClockRule_Taken, // NOTE: Alternate clocks are used when the branch is taken
+    ClockRule_Int3, // NOTE: Alternate clocks are used when the interrupt number is 3
+    ClockRule_Rep, // NOTE: Alternate clocks plus PerCount for each repetition, base clocks when not repeated
+    ClockRule_Shift, // NOTE: Base clocks plus PerCount for each bit shifted by CL
+};
+
+struct instruction_clock_entry
+{
+    u16 Min;
+    u16 Max;
+    u16 Alternate;
+    u8 Transfers;
+    u8 AlternateTransfers;
+    u8 PerCountClocks;
+    u8 PerCountTransfers;
+    instruction_clock_rule Rule;
+    u8 UsesEA;
+};
+
+struct instruction_clock_table
+{
+    instruction_clock_entry *Entries;
+    u32 EntryCount;
+};
+
+struct prefetch_queue
+{
+    u32 StartAddress; // NOTE: Absolute address of the first byte in the queue
+    u32 ByteCount;
+    u32 BusProgress; // NOTE: Clocks already spent on the prefetch bus cycle in flight
+    u32 StallClocks;
+};
+
+struct pipeline_state
+{
+    u32 QueueSize;
+    b32 ByteBus;
+    
+    // NOTE: How far ahead the BIU gets depends on how long the EU takes, so each end of
+    // the clock interval gets its own queue.
+    prefetch_queue Queue[2];
+    instruction_clock_interval Total;
+};
+
 static instruction_timing EstimateInstructionClocks(timing_state State, instruction Instruction);
+static instruction_clock_table Get8086ClockTable();
+static instruction_timing LookupInstructionClocks(instruction_clock_table Table, timing_state State, instruction Instruction);
 static void UpdateTimingForExec(timing_state *State, exec_result Exec);
 static instruction_clock_interval ExpectedClocksFrom(timing_state State, instruction Instruction, instruction_timing Timing);
+
+static pipeline_state InitPipeline(timing_state State);
+static instruction_clock_interval PipelineClocksFrom(pipeline_state *Pipeline, timing_state State, instruction Instruction,
+                                                     instruction_timing Timing, instruction_clock_interval Clocks);
@@ -178,23 +178,77 @@ static void UpdateLogFlags(register_state_8086 *Registers, u16 MaskedResult, u32
     UpdateCommonFlags(Registers, MaskedResult, WWidth);
 }
 
-static void WriteLogOpResult(register_state_8086 *Registers, segmented_access Dest, u16 UnmaskedResult, u32 WWidth)
+static void MaterializeFlags(register_state_8086 *Registers, lazy_flags *Flags)
+{
+    u32 V0 = Flags->V0;
+    u32 V1 = Flags->V1;
+    u32 R = Flags->Result;
+    u32 WWidth = Flags->WWidth;
+    
+    switch(Flags->Op)
+    {
+        case LazyFlags_None:
+        {
+        } break;
+        
+        case LazyFlags_Add:
+        {
+            u32 SignBit = SignBitFor(WWidth);
+            b32 OF = (~(V0 ^ V1) & (V0 ^ R)) & SignBit;
+            b32 AF = ((V0 & 0xf) + (V1 & 0xf)) & 0x10;
+            UpdateArithFlags(Registers, R, R & WidthMaskFor(WWidth), WWidth, OF, AF);
+        } break;
+        
+        case LazyFlags_Sub:
+        {
+            u32 SignBit = SignBitFor(WWidth);
+            b32 OF = ((V0 ^ V1) & (V0 ^ R)) & SignBit;
+            b32 AF = ((V0 & 0xf) - (V1 & 0xf)) & 0x10;
+            UpdateArithFlags(Registers, R, R & WidthMaskFor(WWidth), WWidth, OF, AF);
+        } break;
+        
+        case LazyFlags_Arith:
+        {
+            UpdateArithFlags(Registers, R, R & WidthMaskFor(WWidth), WWidth);
+        } break;
+        
+        case LazyFlags_Logic:
+        {
+            UpdateLogFlags(Registers, (u16)R, WWidth);
+        } break;
+    }
+    
+    Flags->Op = LazyFlags_None;
+}
+
+static void RecordFlags(lazy_flags *Flags, lazy_flags_op Op, u32 V0, u32 V1, u32 Result, u32 WWidth)
+{
+    // NOTE: Every recorded op sets all six arithmetic flags, so whatever was
+    // pending before can simply be dropped.
+    Flags->Op = Op;
+    Flags->V0 = V0;
+    Flags->V1 = V1;
+    Flags->Result = Result;
+    Flags->WWidth = WWidth;
+}
+
+static void WriteLogOpResult(lazy_flags *Flags, segmented_access Dest, u16 UnmaskedResult, u32 WWidth)
 {
     u16 MaskedResult = UnmaskedResult & WidthMaskFor(WWidth);
-    UpdateLogFlags(Registers, MaskedResult, WWidth);
+    RecordFlags(Flags, LazyFlags_Logic, 0, 0, MaskedResult, WWidth);
     WriteN(Dest, 0, MaskedResult, WWidth);
 }
 
-static void WriteArithOpResult(register_state_8086 *Registers, segmented_access Dest, u32 UnmaskedResult, u32 WWidth,
-                               b32 OF = false, b32 AF = false)
+static void WriteArithOpResult(lazy_flags *Flags, segmented_access Dest, u32 UnmaskedResult, u32 WWidth,
+                               lazy_flags_op Op = LazyFlags_Arith, u32 V0 = 0, u32 V1 = 0)
 {
     /* TODO(casey): I didn't like how this came out. Unlike the other writeback functions, AFAICT this one required
-       me to pass in OF and AF since they get computed differently. I assume this is because I don't quite "get" how
-       the ALU is supposed to work, and actually it is simpler than that if you know the right approach.
+       me to pass in the operands since OF and AF get computed differently. I assume this is because I don't quite
+       "get" how the ALU is supposed to work, and actually it is simpler than that if you know the right approach.
     */
     
     u16 MaskedResult = UnmaskedResult & WidthMaskFor(WWidth);
-    UpdateArithFlags(Registers, UnmaskedResult, MaskedResult, WWidth, OF, AF);
+    RecordFlags(Flags, Op, V0, V1, UnmaskedResult, WWidth);
     
     WriteN(Dest, 0, MaskedResult, WWidth);
 }
@@ -305,22 +359,88 @@ static operand_access AccessOperand(segmented_access Memory, register_state_8086
     return Result;
 }
 
-static exec_result ExecInstruction(segmented_access Memory, register_state_8086 *Registers, instruction Instruction)
+static b32 ReadsFlags(operation_type Op)
+{
+    b32 Result = false;
+    
+    switch(Op)
+    {
+        // NOTE: Conditional jumps
+        case Op_je:
+        case Op_jl:
+        case Op_jle:
+        case Op_jb:
+        case Op_jbe:
+        case Op_jp:
+        case Op_jo:
+        case Op_js:
+        case Op_jne:
+        case Op_jnl:
+        case Op_jg:
+        case Op_jnb:
+        case Op_ja:
+        case Op_jnp:
+        case Op_jno:
+        case Op_jns:
+        case Op_loopz:
+        case Op_loopnz:
+        
+        // NOTE: Instructions that copy the flags somewhere else
+        case Op_lahf:
+        case Op_sahf:
+        case Op_pushf:
+        case Op_popf:
+        case Op_int:
+        case Op_int3:
+        case Op_into:
+        case Op_iret:
+        
+        // NOTE: Instructions that only change some of the arithmetic flags
+        case Op_clc:
+        case Op_cmc:
+        case Op_stc:
+        case Op_shl:
+        case Op_shr:
+        case Op_sar:
+        case Op_rol:
+        case Op_ror:
+        case Op_rcl:
+        case Op_rcr:
+        case Op_adc:
+        case Op_sbb:
+        {
+            Result = true;
+        } break;
+        
+        default: {} break;
+    }
+    
+    return Result;
+}
+
+static exec_result ExecInstruction(segmented_access Memory, register_state_8086 *Registers, lazy_flags *Flags,
+                                   instruction Instruction)
 {
     exec_result Result = {};
     
     u32 WWidth = (Instruction.Flags & Inst_Wide) ? 2 : 1;
     b32 IsFar = (Instruction.Flags & Inst_Far);
     
-    b32 CF = Registers->flags & Flag_CF;
-    b32 PF = Registers->flags & Flag_PF;
-    b32 AF = Registers->flags & Flag_AF;
-    b32 ZF = Registers->flags & Flag_ZF;
-    b32 SF = Registers->flags & Flag_SF;
-    b32 OF = Registers->flags & Flag_OF;
-    b32 IF = Registers->flags & Flag_IF;
-    b32 DF = Registers->flags & Flag_DF;
-    b32 TF = Registers->flags & Flag_TF;
+    b32 CF = false;
+    b32 PF = false;
+    b32 ZF = false;
+    b32 SF = false;
+    b32 OF = false;
+    if(ReadsFlags(Instruction.Op))
+    {
+        MaterializeFlags(Registers, Flags);
+        
+        CF = Registers->flags & Flag_CF;
+        PF = Registers->flags & Flag_PF;
+        ZF = Registers->flags & Flag_ZF;
+        SF = Registers->flags & Flag_SF;
+        OF = Registers->flags & Flag_OF;
+    }
     
     segmented_access DefaultSegment = DetermineSegmentAccess(Memory, Instruction, Registers, Registers->ds);
     
@@ -416,12 +536,9 @@ static exec_result ExecInstruction(segmented_access Memory, register_state_8086
         
         case Op_add:
         {
-            u32 SignBit = SignBitFor(WWidth);
             u32 Mask = WidthMaskFor(WWidth);
             u32 R = (V0 & Mask) + (V1 & Mask);
-            b32 OF = (~(V0 ^ V1) & (V0 ^ R)) & SignBit;
-            b32 AF = ((V0 & 0xf) + (V1 & 0xf)) & 0x10;
-            WriteArithOpResult(Registers, Op0, R, WWidth, OF, AF);
+            WriteArithOpResult(Flags, Op0, R, WWidth, LazyFlags_Add, V0, V1);
         } break;
         
         case Op_adc:
@@ -432,7 +549,7 @@ static exec_result ExecInstruction(segmented_access Memory, register_state_8086
         case Op_inc:
         {
             u32 R = V0 + 1;
-            WriteArithOpResult(Registers, Op0, R, WWidth);
+            WriteArithOpResult(Flags, Op0, R, WWidth);
         } break;
         
         case Op_aaa:
@@ -447,12 +564,9 @@ static exec_result ExecInstruction(segmented_access Memory, register_state_8086
         
         case Op_sub:
         {
-            u32 SignBit = SignBitFor(WWidth);
             u32 WidthMask = WidthMaskFor(WWidth);
             u32 R = (V0 & WidthMask) - (V1 & WidthMask);
-            b32 OF = ((V0 ^ V1) & (V0 ^ R)) & SignBit;
-            b32 AF = ((V0 & 0xf) - (V1 & 0xf)) & 0x10;
-            WriteArithOpResult(Registers, Op0, R, WWidth, OF, AF);
+            WriteArithOpResult(Flags, Op0, R, WWidth, LazyFlags_Sub, V0, V1);
         } break;
         
         case Op_sbb:
@@ -463,23 +577,20 @@ static exec_result ExecInstruction(segmented_access Memory, register_state_8086
         case Op_dec:
         {
             u32 R = V0 - 1;
-            WriteArithOpResult(Registers, Op0, R, WWidth);
+            WriteArithOpResult(Flags, Op0, R, WWidth);
         } break;
         
         case Op_neg:
         {
             u32 R = -V0;
-            WriteArithOpResult(Registers, Op0, R, WWidth);
+            WriteArithOpResult(Flags, Op0, R, WWidth);
         } break;
         
         case Op_cmp:
         {
-            u32 SignBit = SignBitFor(WWidth);
             u32 WidthMask = WidthMaskFor(WWidth);
             u32 R = (V0 & WidthMask) - (V1 & WidthMask);
-            b32 OF = ((V0 ^ V1) & (V0 ^ R)) & SignBit;
-            b32 AF = ((V0 & 0xf) - (V1 & 0xf)) & 0x10;
-            UpdateArithFlags(Registers, R, R & WidthMaskFor(WWidth), WWidth, OF, AF);
+            RecordFlags(Flags, LazyFlags_Sub, V0, V1, R, WWidth);
         } break;
         
         case Op_aas:
@@ -495,7 +606,7 @@ static exec_result ExecInstruction(segmented_access Memory, register_state_8086
         case Op_mul:
         {
             u32 R = V0*V1;
-            WriteArithOpResult(Registers, Op0, R, WWidth);
+            WriteArithOpResult(Flags, Op0, R, WWidth);
         } break;
         
         case Op_imul:
@@ -505,7 +616,7 @@ static exec_result ExecInstruction(segmented_access Memory, register_state_8086
             {
                 R = (s32)(s8)V0 * (s32)(s8)V1;
             }
-            WriteArithOpResult(Registers, Op0, R, WWidth);
+            WriteArithOpResult(Flags, Op0, R, WWidth);
         } break;
         
         case Op_aam:
@@ -517,12 +628,13 @@ static exec_result ExecInstruction(segmented_access Memory, register_state_8086
         {
             if(V1 == 0)
             {
+                MaterializeFlags(Registers, Flags);
                 ExecInterrupt(Memory, Registers, 0);
             }
             else
             {
                 u32 R = V0/V1;
-                WriteArithOpResult(Registers, Op0, R, WWidth);
+                WriteArithOpResult(Flags, Op0, R, WWidth);
             }
         } break;
         
@@ -533,7 +645,7 @@ static exec_result ExecInstruction(segmented_access Memory, register_state_8086
             {
                 R = (s32)(s8)V0 / (s32)(s8)V1;
             }
-            WriteArithOpResult(Registers, Op0, R, WWidth);
+            WriteArithOpResult(Flags, Op0, R, WWidth);
         } break;
         
         case Op_aad:
@@ -597,22 +709,22 @@ static exec_result ExecInstruction(segmented_access Memory, register_state_8086
         
         case Op_and:
         {
-            WriteLogOpResult(Registers, Op0, V0 & V1, WWidth);
+            WriteLogOpResult(Flags, Op0, V0 & V1, WWidth);
         } break;
         
         case Op_test:
         {
-            UpdateLogFlags(Registers, V0 & V1, WWidth);
+            RecordFlags(Flags, LazyFlags_Logic, 0, 0, (u16)(V0 & V1), WWidth);
         } break;
         
         case Op_or:
         {
-            WriteLogOpResult(Registers, Op0, V0 | V1, WWidth);
+            WriteLogOpResult(Flags, Op0, V0 | V1, WWidth);
         } break;
         
         case Op_xor:
         {
-            WriteLogOpResult(Registers, Op0, V0 ^ V1, WWidth);
+            WriteLogOpResult(Flags, Op0, V0 ^ V1, WWidth);
         } break;
         
         case Op_movs:
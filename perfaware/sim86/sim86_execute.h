@@ -76,4 +76,28 @@ struct operand_access
     b32 AddressIsUnaligned;
 };
 
-static exec_result ExecInstruction(segmented_access Memory, register_state_8086 *Registers, instruction Instruction);
+/* NOTE: Most arithmetic results are overwritten by the next arithmetic op before anything looks at
+   the flags, so ExecInstruction only records what the last flag-setting op was. Registers->flags is brought
+   up to date when an instruction reads the flags, or when the caller calls MaterializeFlags because it
+   needs the flags register to be exact (to print it, for example). */
+enum lazy_flags_op : u32
+{
+    LazyFlags_None, // NOTE: Registers->flags is already up to date
+    LazyFlags_Add,
+    LazyFlags_Sub,
+    LazyFlags_Arith, // NOTE: Arithmetic that leaves OF and AF clear
+    LazyFlags_Logic,
+};
+
+struct lazy_flags
+{
+    lazy_flags_op Op;
+    u32 V0;
+    u32 V1;
+    u32 Result;
+    u32 WWidth;
+};
+
+static void MaterializeFlags(register_state_8086 *Registers, lazy_flags *Flags);
+static exec_result ExecInstruction(segmented_access Memory, register_state_8086 *Registers, lazy_flags *Flags,
+                                   instruction Instruction);
@@ -0,0 +1,311 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+static b32 IsControlTransfer(operation_type Op)
+{
+    b32 Result = false;
+    
+    switch(Op)
+    {
+        case Op_je:
+        case Op_jl:
+        case Op_jle:
+        case Op_jb:
+        case Op_jbe:
+        case Op_jp:
+        case Op_jo:
+        case Op_js:
+        case Op_jne:
+        case Op_jnl:
+        case Op_jg:
+        case Op_jnb:
+        case Op_ja:
+        case Op_jnp:
+        case Op_jno:
+        case Op_jns:
+        case Op_jcxz:
+        case Op_loop:
+        case Op_loopz:
+        case Op_loopnz:
+        case Op_jmp:
+        case Op_call:
+        case Op_ret:
+        case Op_retf:
+        case Op_int:
+        case Op_int3:
+        case Op_into:
+        case Op_iret:
+        {
+            Result = true;
+        } break;
+        
+        default: {} break;
+    }
+    
+    return Result;
+}
+
+static profile AllocateProfile(u32 MemorySize, u32 MaxAddressCount)
+{
+    profile Result = {};
+    
+    Result.SlotForAddress = (u32 *)calloc(MemorySize, sizeof(u32));
+    Result.Addresses = (profile_address *)malloc(MaxAddressCount*sizeof(profile_address));
+    if(Result.SlotForAddress && Result.Addresses)
+    {
+        Result.AddressMask = MemorySize - 1;
+        Result.MaxAddressCount = MaxAddressCount;
+    }
+    
+    Result.NextStartsBlock = true;
+    
+    return Result;
+}
+
+static void FreeProfile(profile *Profile)
+{
+    free(Profile->SlotForAddress);
+    free(Profile->Addresses);
+    
+    profile Empty = {};
+    *Profile = Empty;
+}
+
+static void ProfileInstruction(profile *Profile, instruction Instruction, instruction_clock_interval Clocks)
+{
+    // NOTE: A basic block starts wherever execution did not just fall through from the previous
+    // instruction, and after any instruction that can transfer control. The flag is sticky, so a loop
+    // head that was first reached by falling into it still starts a block once it is jumped to.
+    b32 StartsBlock = (Profile->NextStartsBlock || (Instruction.Address != Profile->NextAddress));
+    Profile->NextStartsBlock = IsControlTransfer(Instruction.Op);
+    Profile->NextAddress = Instruction.Address + Instruction.Size;
+    
+    ++Profile->ExecCount;
+    Profile->TotalMin += Clocks.Min;
+    Profile->TotalMax += Clocks.Max;
+    
+    profile_address *Entry = 0;
+    if(Profile->MaxAddressCount)
+    {
+        u32 *Slot = &Profile->SlotForAddress[Instruction.Address & Profile->AddressMask];
+        if(*Slot)
+        {
+            Entry = &Profile->Addresses[*Slot - 1];
+        }
+        else if(Profile->AddressCount < Profile->MaxAddressCount)
+        {
+            Entry = &Profile->Addresses[Profile->AddressCount++];
+            *Slot = Profile->AddressCount;
+            
+            profile_address Empty = {};
+            *Entry = Empty;
+            Entry->Clocks = Clocks;
+        }
+    }
+    
+    if(Entry)
+    {
+        Entry->Instruction = Instruction;
+        
+        ++Entry->ExecCount;
+        Entry->TotalMin += Clocks.Min;
+        Entry->TotalMax += Clocks.Max;
+        
+        if(Entry->Clocks.Min > Clocks.Min) Entry->Clocks.Min = Clocks.Min;
+        if(Entry->Clocks.Max < Clocks.Max) Entry->Clocks.Max = Clocks.Max;
+        
+        Entry->StartsBlock |= StartsBlock;
+    }
+    else
+    {
+        ++Profile->DroppedCount;
+    }
+}
+
+static int CompareProfileAddressesByAddress(void const *A, void const *B)
+{
+    u32 AddressA = ((profile_address const *)A)->Instruction.Address;
+    u32 AddressB = ((profile_address const *)B)->Instruction.Address;
+    
+    int Result = (AddressA < AddressB) ? -1 : (AddressA > AddressB);
+    return Result;
+}
+
+static int CompareProfileAddressesByClocks(void const *A, void const *B)
+{
+    profile_address const *EntryA = (profile_address const *)A;
+    profile_address const *EntryB = (profile_address const *)B;
+    
+    int Result = 0;
+    if(EntryA->TotalMax != EntryB->TotalMax)
+    {
+        Result = (EntryA->TotalMax > EntryB->TotalMax) ? -1 : 1;
+    }
+    else
+    {
+        Result = CompareProfileAddressesByAddress(A, B);
+    }
+    
+    return Result;
+}
+
+static int CompareProfileBlocksByClocks(void const *A, void const *B)
+{
+    profile_block const *BlockA = (profile_block const *)A;
+    profile_block const *BlockB = (profile_block const *)B;
+    
+    // NOTE: Blocks index into the address-sorted array, so ties fall back to address order.
+    int Result = 0;
+    if(BlockA->TotalMax != BlockB->TotalMax)
+    {
+        Result = (BlockA->TotalMax > BlockB->TotalMax) ? -1 : 1;
+    }
+    else
+    {
+        Result = (BlockA->FirstAddressIndex < BlockB->FirstAddressIndex) ? -1 : 1;
+    }
+    
+    return Result;
+}
+
+static void PrintProfileClocks(u64 Min, u64 Max, u64 Total, FILE *Dest)
+{
+    char Clocks[64];
+    if(Min != Max)
+    {
+        sprintf(Clocks, "[%llu,%llu]", Min, Max);
+    }
+    else
+    {
+        sprintf(Clocks, "%llu", Min);
+    }
+    
+    double Share = Total ? (100.0*(double)Max / (double)Total) : 0.0;
+    fprintf(Dest, "%14s %6.2f%%", Clocks, Share);
+}
+
+static void PrintProfileAddress(profile_address *Entry, u64 Total, FILE *Dest)
+{
+    PrintProfileClocks(Entry->TotalMin, Entry->TotalMax, Total, Dest);
+    
+    char Each[32];
+    if(Entry->Clocks.Min != Entry->Clocks.Max)
+    {
+        sprintf(Each, "%u-%u", Entry->Clocks.Min, Entry->Clocks.Max);
+    }
+    else
+    {
+        sprintf(Each, "%u", Entry->Clocks.Min);
+    }
+    
+    fprintf(Dest, " %10llu %9s  %05x  ", Entry->ExecCount, Each, Entry->Instruction.Address);
+    PrintInstruction(Entry->Instruction, Dest);
+    fprintf(Dest, "\n");
+}
+
+static void PrintProfile(profile *Profile, FILE *Dest)
+{
+    fprintf(Dest, "--- profile ---\n");
+    fprintf(Dest, "Executed %llu instructions at %u addresses, clocks: ", Profile->ExecCount, Profile->AddressCount);
+    if(Profile->TotalMin != Profile->TotalMax)
+    {
+        fprintf(Dest, "[%llu,%llu]\n", Profile->TotalMin, Profile->TotalMax);
+    }
+    else
+    {
+        fprintf(Dest, "%llu\n", Profile->TotalMin);
+    }
+    
+    if(Profile->DroppedCount)
+    {
+        fprintf(Dest, "WARNING: %llu executions were not attributed because more than %u distinct addresses were executed.\n",
+                Profile->DroppedCount, Profile->MaxAddressCount);
+    }
+    
+    u32 Count = Profile->AddressCount;
+    profile_address *ByAddress = (profile_address *)malloc(Count*sizeof(profile_address) + 1);
+    profile_address *ByClocks = (profile_address *)malloc(Count*sizeof(profile_address) + 1);
+    profile_block *Blocks = (profile_block *)malloc(Count*sizeof(profile_block) + 1);
+    if(ByAddress && ByClocks && Blocks)
+    {
+        memcpy(ByAddress, Profile->Addresses, Count*sizeof(profile_address));
+        memcpy(ByClocks, Profile->Addresses, Count*sizeof(profile_address));
+        qsort(ByAddress, Count, sizeof(profile_address), CompareProfileAddressesByAddress);
+        qsort(ByClocks, Count, sizeof(profile_address), CompareProfileAddressesByClocks);
+        
+        u32 BlockCount = 0;
+        profile_block *Block = 0;
+        for(u32 Index = 0; Index < Count; ++Index)
+        {
+            profile_address *Entry = &ByAddress[Index];
+            
+            b32 StartsBlock = (Entry->StartsBlock || !Block);
+            if(!StartsBlock)
+            {
+                instruction Prev = ByAddress[Index - 1].Instruction;
+                StartsBlock = (((Prev.Address + Prev.Size) != Entry->Instruction.Address) ||
+                               IsControlTransfer(Prev.Op));
+            }
+            
+            if(StartsBlock)
+            {
+                Block = &Blocks[BlockCount++];
+                Block->FirstAddressIndex = Index;
+                Block->AddressCount = 0;
+                Block->ExecCount = Entry->ExecCount;
+                Block->TotalMin = 0;
+                Block->TotalMax = 0;
+            }
+            
+            ++Block->AddressCount;
+            Block->TotalMin += Entry->TotalMin;
+            Block->TotalMax += Entry->TotalMax;
+        }
+        
+        qsort(Blocks, BlockCount, sizeof(profile_block), CompareProfileBlocksByClocks);
+        
+        fprintf(Dest, "\nHot instructions:\n");
+        fprintf(Dest, "%14s %7s %10s %9s  %5s  %s\n", "clocks", "share", "count", "each", "addr", "instruction");
+        for(u32 Index = 0; Index < Count; ++Index)
+        {
+            PrintProfileAddress(&ByClocks[Index], Profile->TotalMax, Dest);
+        }
+        
+        fprintf(Dest, "\nHot basic blocks:\n");
+        fprintf(Dest, "%14s %7s %10s %9s  %5s  %s\n", "clocks", "share", "count", "each", "addr", "instruction");
+        for(u32 BlockIndex = 0; BlockIndex < BlockCount; ++BlockIndex)
+        {
+            Block = &Blocks[BlockIndex];
+            profile_address *First = &ByAddress[Block->FirstAddressIndex];
+            profile_address *Last = First + (Block->AddressCount - 1);
+            
+            fprintf(Dest, "\n");
+            PrintProfileClocks(Block->TotalMin, Block->TotalMax, Profile->TotalMax, Dest);
+            fprintf(Dest, " %10llu %9s  %05x-%05x (%u instruction%s)\n", Block->ExecCount, "",
+                    First->Instruction.Address, Last->Instruction.Address + Last->Instruction.Size,
+                    Block->AddressCount, (Block->AddressCount == 1) ? "" : "s");
+            
+            for(u32 Index = 0; Index < Block->AddressCount; ++Index)
+            {
+                PrintProfileAddress(First + Index, Profile->TotalMax, Dest);
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate memory for the profile report.\n");
+    }
+    
+    free(ByAddress);
+    free(ByClocks);
+    free(Blocks);
+}
@@ -0,0 +1,59 @@
+/* ========================================================================
+
+   (C) Copyright 2023 by Molly Rocket, Inc., All Rights Reserved.
+   
+   This software is provided 'as-is', without any express or implied
+   warranty. In no event will the authors be held liable for any damages
+   arising from the use of this software.
+   
+   Please see https://computerenhance.com for more information
+   
+   ======================================================================== */
+
+struct profile_address
+{
+    instruction Instruction;
+    
+    u64 ExecCount;
+    u64 TotalMin;
+    u64 TotalMax;
+    
+    instruction_clock_interval Clocks; // NOTE: Cheapest and most expensive single execution
+    
+    b32 StartsBlock;
+};
+
+struct profile_block
+{
+    u32 FirstAddressIndex;
+    u32 AddressCount;
+    
+    u64 ExecCount;
+    u64 TotalMin;
+    u64 TotalMax;
+};
+
+struct profile
+{
+    // NOTE: Indexed by absolute address. 0 means the address has not been executed,
+    // otherwise it is one more than the index of its entry in Addresses.
+    u32 *SlotForAddress;
+    u32 AddressMask;
+    
+    profile_address *Addresses;
+    u32 AddressCount;
+    u32 MaxAddressCount;
+    
+    u64 ExecCount;
+    u64 TotalMin;
+    u64 TotalMax;
+    u64 DroppedCount;
+    
+    b32 NextStartsBlock;
+    u32 NextAddress;
+};
+
+static profile AllocateProfile(u32 MemorySize, u32 MaxAddressCount);
+static void FreeProfile(profile *Profile);
+static void ProfileInstruction(profile *Profile, instruction Instruction, instruction_clock_interval Clocks);
+static void PrintProfile(profile *Profile, FILE *Dest);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Core.hpp"
+
+/*
+ * Binary, columnar alternative to data.json. A 64 byte header is followed by
+ * the x0, y0, x1 and y1 columns, each an array of f64. The columns are
+ * ColumnStride values apart and the stride is rounded up to a cache line, so
+ * every column starts 64 byte aligned and can be used straight out of a
+ * mapping of the file.
+ */
+
+// NOTE: "HVCOLNS1" in little endian byte order.
+constexpr u64 BINARY_PAIRS_MAGIC = 0x31534E4C4F435648ull;
+
+enum BinaryColumn : u32
+{
+    BINARY_COLUMN_X0,
+    BINARY_COLUMN_Y0,
+    BINARY_COLUMN_X1,
+    BINARY_COLUMN_Y1,
+
+    BINARY_COLUMN_COUNT
+};
+
+struct BinaryPairsHeader
+{
+    u64 Magic;
+    u64 PairCount;
+    u64 Seed;
+    u64 ColumnStride;
+    f64 ExpectedResult;
+    u64 Reserved[3];
+};
+
+static_assert(sizeof(BinaryPairsHeader) == 64, "The columns have to start on a cache line");
+
+inline u64 GetBinaryColumnStride(u64 pairCount)
+{
+    constexpr u64 valuesPerCacheLine = 64 / sizeof(f64);
+    return (pairCount + valuesPerCacheLine - 1) & ~(valuesPerCacheLine - 1);
+}
+
+inline u64 GetBinaryColumnOffset(u64 columnStride, u32 column, u64 pairIndex)
+{
+    return sizeof(BinaryPairsHeader) + (column * columnStride + pairIndex) * sizeof(f64);
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+
+#include "Core.hpp"
+#include "HashFunctions.hpp"
+#include "MappedFile.hpp"
+#include "Validation.hpp"
+
+/*
+ * blocks.bin lets a run be checked without results.bin. For every block of
+ * BLOCK_CHECKSUM_PAIRS pairs the generator stores the sum of the block's
+ * distances and a hash over the text of the block's pair objects, each one
+ * from its '{' through its '}'. Every block can be checked on its own: a wrong
+ * hash means the input text changed, a right hash with a wrong sum means the
+ * computation diverged.
+ */
+
+constexpr u64 BLOCK_CHECKSUM_PAIRS = 64 * 1024;
+
+// NOTE: "HVBLOCK1" in little endian byte order.
+constexpr u64 BLOCK_CHECKSUM_MAGIC = 0x314B434F4C425648ull;
+
+// NOTE: The JSON parser is not correctly rounded, so coordinates read from text can be a few
+//       ULPs off and the block sums come out slightly different from the generator's. Each
+//       pair's error carries into its block sum at roughly the same number of the sum's ULPs,
+//       and summing the block can add up to another ULP per pair, so JSON block sums are
+//       allowed this many ULPs plus one per pair. The binary file holds the generator's exact
+//       values and has to match bit for bit.
+constexpr u64 JSON_BLOCK_SUM_ULP_ALLOWANCE = 65536;
+
+struct BlockChecksumHeader
+{
+    u64 Magic;
+    u64 PairCount;
+    u64 BlockPairCount;
+    u64 BlockCount;
+    f64 ExpectedResult;
+    u64 Reserved[3];
+};
+
+struct BlockChecksum
+{
+    f64 Sum;
+    u64 TextHash;
+};
+
+inline u64 AddPairTextToHash(u64 hash, const byte* text, i64 size)
+{
+    return HashMultiplyFold(hash ^ HashBytes(text, size), 0x9E3779B97F4A7C15ull);
+}
+
+struct BlockCheck
+{
+    MappedFile File;
+    const BlockChecksumHeader* Header;
+    const BlockChecksum* Expected;
+
+    bool TextChecked;
+    u64 TextMismatchCount;
+    u64 FirstTextMismatch;
+
+    bool ExactSums;
+    f64 BlockSum;
+    u64 MaxSumUlps;
+    u64 SumMismatchCount;
+    u64 FirstSumMismatch;
+    f64 FirstMismatchSum;
+};
+
+// NOTE: Returns false when the file is missing or broken. The caller still has to compare
+//       the pair count in the header against the pairs it actually has.
+inline bool OpenBlockCheck(BlockCheck* check, const char* name)
+{
+    *check = {};
+    check->File = MapFile(name);
+
+    const BlockChecksumHeader* header = REINTERPRET(const BlockChecksumHeader*, check->File.Data);
+    if(check->File.Size < sizeof(BlockChecksumHeader) ||
+       header->Magic != BLOCK_CHECKSUM_MAGIC ||
+       header->BlockPairCount == 0 ||
+       header->BlockCount != (header->PairCount + header->BlockPairCount - 1) / header->BlockPairCount ||
+       check->File.Size < sizeof(BlockChecksumHeader) + header->BlockCount * sizeof(BlockChecksum))
+    {
+        UnmapFile(&check->File);
+        return false;
+    }
+
+    check->Header = header;
+    check->Expected = REINTERPRET(const BlockChecksum*, header + 1);
+    return true;
+}
+
+// NOTE: The first '{' opens the outer object, every following one opens a pair.
+inline void CheckBlockText(BlockCheck* check, const char* text, u64 size)
+{
+    const char* end = text + size;
+    const char* at = CAST(const char*, memchr(text, '{', size));
+    if(at == nullptr)
+    {
+        return;
+    }
+    at++;
+
+    u64 hash = 0;
+    for(u64 index = 0; index < check->Header->PairCount; index++)
+    {
+        const char* open = CAST(const char*, memchr(at, '{', CAST(size_t, end - at)));
+        const char* close = open != nullptr ? CAST(const char*, memchr(open, '}', CAST(size_t, end - open))) : nullptr;
+        if(close == nullptr)
+        {
+            return;
+        }
+
+        hash = AddPairTextToHash(hash, REINTERPRET(const byte*, open), close + 1 - open);
+        at = close + 1;
+
+        u64 blockIndex = index / check->Header->BlockPairCount;
+        bool lastInBlock = (index + 1) % check->Header->BlockPairCount == 0 || index + 1 == check->Header->PairCount;
+        if(lastInBlock)
+        {
+            if(hash != check->Expected[blockIndex].TextHash)
+            {
+                if(check->TextMismatchCount == 0)
+                {
+                    check->FirstTextMismatch = blockIndex;
+                }
+                check->TextMismatchCount++;
+            }
+            hash = 0;
+        }
+    }
+
+    check->TextChecked = true;
+}
+
+inline u64 GetAllowedSumUlps(const BlockCheck* check)
+{
+    return check->ExactSums ? 0 : JSON_BLOCK_SUM_ULP_ALLOWANCE + check->Header->BlockPairCount;
+}
+
+// NOTE: Has to be called for every pair in order, the block sum is compared after its last pair.
+inline void AddBlockDistance(BlockCheck* check, u64 index, f64 distance)
+{
+    check->BlockSum += distance;
+
+    bool lastInBlock = (index + 1) % check->Header->BlockPairCount == 0 || index + 1 == check->Header->PairCount;
+    if(!lastInBlock)
+    {
+        return;
+    }
+
+    u64 blockIndex = index / check->Header->BlockPairCount;
+    u64 sumUlps = GetUlpDistance(check->BlockSum, check->Expected[blockIndex].Sum);
+    if(sumUlps > check->MaxSumUlps)
+    {
+        check->MaxSumUlps = sumUlps;
+    }
+
+    if(sumUlps > GetAllowedSumUlps(check))
+    {
+        if(check->SumMismatchCount == 0)
+        {
+            check->FirstSumMismatch = blockIndex;
+            check->FirstMismatchSum = check->BlockSum;
+        }
+        check->SumMismatchCount++;
+    }
+
+    check->BlockSum = 0.0;
+}
+
+inline void PrintBlockCheck(const BlockCheck* check)
+{
+    printf("blocks checked: %llu\n", CAST(unsigned long long, check->Header->BlockCount));
+
+    if(!check->TextChecked)
+    {
+        printf("text hashes: not checked\n");
+    }
+    else if(check->TextMismatchCount == 0)
+    {
+        printf("text hashes: all match\n");
+    }
+    else
+    {
+        printf("text hash mismatches: %llu, first at block %llu (pairs from %llu)\n",
+               CAST(unsigned long long, check->TextMismatchCount),
+               CAST(unsigned long long, check->FirstTextMismatch),
+               CAST(unsigned long long, check->FirstTextMismatch * check->Header->BlockPairCount));
+    }
+
+    if(check->SumMismatchCount == 0)
+    {
+        if(check->ExactSums)
+        {
+            printf("block sums: all match\n");
+        }
+        else
+        {
+            printf("block sums: all within %llu ULPs (max %llu)\n",
+                   CAST(unsigned long long, GetAllowedSumUlps(check)),
+                   CAST(unsigned long long, check->MaxSumUlps));
+        }
+    }
+    else
+    {
+        printf("block sum mismatches: %llu over %llu ULPs, first at block %llu (%.17f, expected %.17f)\n",
+               CAST(unsigned long long, check->SumMismatchCount),
+               CAST(unsigned long long, GetAllowedSumUlps(check)),
+               CAST(unsigned long long, check->FirstSumMismatch),
+               check->FirstMismatchSum,
+               check->Expected[check->FirstSumMismatch].Sum);
+    }
+}
@@ -14,19 +14,26 @@ template<typename TKey, typename TValue>
 class DictionaryNode
 {
     public:
-    explicit DictionaryNode(const TKey& key, const TValue& value) :
+    explicit DictionaryNode(const TKey& key, const TValue& value, u64 hash) :
         Next(nullptr),
         Value(value),
-        mKey(key)
+        mKey(key),
+        mHash(hash)
     {}
     
     TKey& Key() { return mKey; }
+    u64 Hash() const { return mHash; }
     
     DictionaryNode<TKey, TValue>* Next = nullptr;
     TValue Value;
 
     private:
     TKey mKey;
+
+    // NOTE: The full hash of the key is kept with the node, so resizing never
+    //       has to hash a key again and most mismatches in a bucket are rejected
+    //       without comparing the keys themselves.
+    u64 mHash;
 };
 
 template<typename TKey, typename TValue>
@@ -146,11 +153,12 @@ class Dictionary
     
     bool TryAdd(const TKey& key, const TValue& value)
     {
-        i64 hash = Hash(key, mCapacity);
+        u64 hash = Hash(key);
+        i64 index = CAST(i64, hash % mCapacity);
         Node* prev = nullptr;
-        Node* entry = mTable[hash];
+        Node* entry = mTable[index];
         
-        while(entry != nullptr && entry->Key() != key)
+        while(entry != nullptr && !IsMatch(entry, key, hash))
         {
             prev = entry;
             entry = entry->Next;
@@ -158,10 +166,10 @@ class Dictionary
         
         if(entry == nullptr)
         {
-            entry = new Node(key, value);
+            entry = new Node(key, value, hash);
             if(prev == nullptr)
             {
-                mTable[hash] = entry;
+                mTable[index] = entry;
             }
             else
             {
@@ -213,12 +221,12 @@ class Dictionary
     
     Nullable<TValue> operator[](const TKey& key)
     {
-        i64 hash = Hash(key, mCapacity);
-        Node* entry = mTable[hash];
+        u64 hash = Hash(key);
+        Node* entry = mTable[hash % mCapacity];
         
         while(entry != nullptr)
         {
-            if(entry->Key() == key)
+            if(IsMatch(entry, key, hash))
             {
                 return { true, &entry->Value };
             }
@@ -232,11 +240,12 @@ class Dictionary
     [[maybe_unused]]
     bool Remove(const TKey& key)
     {
-        i64 hash = Hash(key, mCapacity);
+        u64 hash = Hash(key);
+        i64 index = CAST(i64, hash % mCapacity);
         Node* prev = nullptr;
-        Node* entry = mTable[hash];
+        Node* entry = mTable[index];
         
-        while(entry != nullptr && entry->Key() != key)
+        while(entry != nullptr && !IsMatch(entry, key, hash))
         {
             prev = entry;
             entry = entry->Next;
@@ -248,7 +257,7 @@ class Dictionary
         }
         if(prev == nullptr)
         {
-            mTable[hash] = entry->Next;
+            mTable[index] = entry->Next;
         }
         else
         {
@@ -268,33 +277,17 @@ class Dictionary
 
         mTable = (Node**)calloc(newCapacity, sizeof(Node*));
 
+        // NOTE: The nodes are relinked into their new buckets instead of being copied,
+        //       the cached hash of each node gives us the new bucket directly.
         for(i64 i = 0; i < mCapacity; i++)
         {
             Node* node = temp[i];
             while(node != nullptr)
             {
-                i64 newHash = Hash(node->Key(), newCapacity);
-                Node* newLocation = mTable[newHash];
-                Node* previous = nullptr;
-                
-                while(newLocation != nullptr)
-                {
-                    previous = newLocation;
-                    newLocation = newLocation->Next;
-                }
-
-                auto newNode = new Node(node->Key(), node->Value);
-                if(previous == nullptr)
-                {
-                    mTable[newHash] = newNode;
-                }
-                else
-                {
-                    previous->Next = newNode;
-                }
-
                 Node* next = node->Next;
-                free(node);
+                i64 newIndex = CAST(i64, node->Hash() % newCapacity);
+                node->Next = mTable[newIndex];
+                mTable[newIndex] = node;
                 node = next;
             }
         }
@@ -305,8 +298,8 @@ class Dictionary
 
     b32 ContainsKey(const TKey& key)
     {
-        i64 hash = Hash(key, mCapacity);
-        Node* node = mTable[hash];
+        u64 hash = Hash(key);
+        Node* node = mTable[hash % mCapacity];
 
         if(node == nullptr)
         {
@@ -315,7 +308,7 @@ class Dictionary
 
         while(node != nullptr)
         {
-            if(node->Key() == key)
+            if(IsMatch(node, key, hash))
             {
                 return true;
             }
@@ -353,6 +346,11 @@ class Dictionary
     }
     
     private:
+    static b32 IsMatch(Node* node, const TKey& key, u64 hash)
+    {
+        return node->Hash() == hash && node->Key() == key;
+    }
+
     i64 mCapacity;
     i64 mCount;
     Node** mTable;
@@ -0,0 +1,201 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Format.hpp"
+
+/*
+ * A double is mantissa / 2^shift. Rounding mantissa * 10^precision / 2^shift
+ * to the nearest integer, ties to even, gives exactly the digits printf
+ * prints. The mantissa has 53 bits and 10^17 fits in 57, so the product
+ * always fits in 128 bits. The integer and fraction part are then written
+ * two digits at a time from a table.
+ */
+
+namespace Format
+{
+    constexpr u64 PowersOf10[] =
+    {
+        1ull,
+        10ull,
+        100ull,
+        1000ull,
+        10000ull,
+        100000ull,
+        1000000ull,
+        10000000ull,
+        100000000ull,
+        1000000000ull,
+        10000000000ull,
+        100000000000ull,
+        1000000000000ull,
+        10000000000000ull,
+        100000000000000ull,
+        1000000000000000ull,
+        10000000000000000ull,
+        100000000000000000ull,
+        1000000000000000000ull,
+        10000000000000000000ull,
+    };
+
+    constexpr char DigitPairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    // NOTE: Writes exactly digitCount digits that end right before end, padded with zeros.
+    static void WriteDigitsBackwards(char* end, u64 value, u32 digitCount)
+    {
+        while(digitCount >= 2)
+        {
+            end -= 2;
+            memcpy(end, DigitPairs + 2 * (value % 100), 2);
+            value /= 100;
+            digitCount -= 2;
+        }
+
+        if(digitCount != 0)
+        {
+            *--end = CAST(char, '0' + value % 10);
+        }
+    }
+
+    static u32 CountDigits(u64 value)
+    {
+        u32 count = 1;
+        while(count < ARRAY_LENGTH(PowersOf10) && value >= PowersOf10[count])
+        {
+            count++;
+        }
+
+        return count;
+    }
+
+    // NOTE: Full 64x64 -> 128 bit product from 32 bit halves, so it builds on every compiler.
+    static void Multiply64x64(u64 a, u64 b, u64* high, u64* low)
+    {
+        u64 aLow = a & 0xFFFFFFFF;
+        u64 aHigh = a >> 32;
+        u64 bLow = b & 0xFFFFFFFF;
+        u64 bHigh = b >> 32;
+
+        u64 lowLow = aLow * bLow;
+        u64 lowHigh = aLow * bHigh;
+        u64 highLow = aHigh * bLow;
+        u64 highHigh = aHigh * bHigh;
+
+        u64 cross = (lowLow >> 32) + (lowHigh & 0xFFFFFFFF) + (highLow & 0xFFFFFFFF);
+        *low = (cross << 32) | (lowLow & 0xFFFFFFFF);
+        *high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (cross >> 32);
+    }
+
+    // NOTE: Returns false when the rounded result does not fit into 64 bits.
+    static b32 ScaleToFixed(u64 mantissa, u32 shift, u32 precision, u64* result)
+    {
+        u64 high = 0;
+        u64 low = 0;
+        Multiply64x64(mantissa, PowersOf10[precision], &high, &low);
+
+        u64 scaled = 0;
+        b32 roundUp = false;
+        if(shift >= 128)
+        {
+            // NOTE: The product is below 2^110, shifting it out completely leaves less than half.
+        }
+        else if(shift > 64)
+        {
+            u32 highShift = shift - 64;
+            u64 remainderHigh = high & ((1ull << highShift) - 1);
+            u64 halfHigh = 1ull << (highShift - 1);
+            scaled = high >> highShift;
+            roundUp = remainderHigh > halfHigh || (remainderHigh == halfHigh && (low != 0 || (scaled & 1) != 0));
+        }
+        else if(shift == 64)
+        {
+            u64 half = 1ull << 63;
+            scaled = high;
+            roundUp = low > half || (low == half && (scaled & 1) != 0);
+        }
+        else
+        {
+            if((high >> shift) != 0)
+            {
+                return false;
+            }
+
+            u64 remainder = low & ((1ull << shift) - 1);
+            u64 half = 1ull << (shift - 1);
+            scaled = (low >> shift) | (high << (64 - shift));
+            roundUp = remainder > half || (remainder == half && (scaled & 1) != 0);
+        }
+
+        if(roundUp)
+        {
+            if(scaled == U64_MAX)
+            {
+                return false;
+            }
+
+            scaled++;
+        }
+
+        *result = scaled;
+        return true;
+    }
+}
+
+char* FormatFixed(char* destination, f64 value, u32 precision)
+{
+    u64 bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+
+    b32 negative = CAST(b32, bits >> 63);
+    u32 biasedExponent = CAST(u32, (bits >> 52) & 0x7FF);
+    u64 mantissa = bits & ((1ull << 52) - 1);
+
+    // NOTE: Denormals have no implicit one and the scale of the smallest normal. From
+    //       2^52 on the values are integers, those and NaN/infinity go to sprintf.
+    u32 shift = 1074;
+    if(biasedExponent != 0)
+    {
+        mantissa |= 1ull << 52;
+        shift = 1075 - biasedExponent;
+    }
+
+    u64 scaled = 0;
+    b32 fits = precision <= MAX_FIXED_PRECISION &&
+               biasedExponent < 1075 &&
+               Format::ScaleToFixed(mantissa, shift, precision, &scaled);
+
+    if(!fits)
+    {
+        return destination + sprintf(destination, "%.*f", CAST(i32, precision), value);
+    }
+
+    u64 integer = scaled / Format::PowersOf10[precision];
+    u64 fraction = scaled % Format::PowersOf10[precision];
+
+    if(negative)
+    {
+        *destination++ = '-';
+    }
+
+    u32 integerDigits = Format::CountDigits(integer);
+    Format::WriteDigitsBackwards(destination + integerDigits, integer, integerDigits);
+    destination += integerDigits;
+
+    if(precision != 0)
+    {
+        *destination++ = '.';
+        Format::WriteDigitsBackwards(destination + precision, fraction, precision);
+        destination += precision;
+    }
+
+    return destination;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Core.hpp"
+
+/*
+ * Fixed precision number formatting for the generator. The text is exactly
+ * what printf("%.*f") produces, but nothing goes through printf or the
+ * locale, the digits are written straight into the caller's buffer.
+ */
+
+// NOTE: The largest precision the fast path handles, anything above goes to sprintf.
+constexpr u32 MAX_FIXED_PRECISION = 17;
+
+// NOTE: Longest text FormatFixed can produce for a precision of at most
+//       MAX_FIXED_PRECISION: sign, 309 integer digits, point and fraction.
+constexpr u32 MAX_FIXED_LENGTH = 1 + 309 + 1 + MAX_FIXED_PRECISION;
+
+// NOTE: Returns one past the last character written, no terminator is written.
+INTERNAL char* FormatFixed(char* destination, f64 value, u32 precision);
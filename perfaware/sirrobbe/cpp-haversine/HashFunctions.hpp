@@ -1,35 +1,83 @@
 #pragma once
 
+#include <cstring>
 #include "Core.hpp"
-#include "String.hpp"
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+INTERNAL u64 Hash(int value);
 INTERNAL i64 Hash(int value, i64 tableSize);
-INTERNAL u64 Hash(const String& value);
-INTERNAL i64 Hash(const String& value, i64 tableSize);
+INTERNAL u64 HashBytes(const byte* data, i64 size);
+
+[[maybe_unused]] INTERNAL u64 Hash(int value)
+{
+    return CAST(u64, value);
+}
 
 [[maybe_unused]] INTERNAL i64 Hash(int value, i64 tableSize)
 {
-    return value % tableSize;
+    return CAST(i64, Hash(value) % tableSize);
+}
+
+// NOTE: Multiplies both values to a 128 bit result and folds the upper half into
+//       the lower one. This is the mixing step of wyhash.
+INTERNAL u64 HashMultiplyFold(u64 a, u64 b)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    u64 high = 0;
+    u64 low = _umul128(a, b, &high);
+    return low ^ high;
+#else
+    __uint128_t product = CAST(__uint128_t, a) * b;
+    return CAST(u64, product) ^ CAST(u64, product >> 64);
+#endif
+}
+
+INTERNAL u64 HashRead(const byte* data, i64 size)
+{
+    // NOTE: memcpy compiles down to a single unaligned load for a size of 8
+    u64 value = 0;
+    memcpy(&value, data, size);
+    return value;
 }
 
-[[maybe_unused]] INTERNAL u64 Hash(const String& value)
+/*
+ * Hashes raw bytes eight at a time in the style of wyhash. This is much
+ * cheaper than hashing decoded codepoints one by one, and because UTF-8
+ * encodes every codepoint in exactly one way equal strings still produce
+ * equal hashes.
+ */
+[[maybe_unused]] INTERNAL u64 HashBytes(const byte* data, i64 size)
 {
-    // NOTE(Daniel): djb2 hashing function, but adapted to scale it
-    // into the range of the hashtable
-    u64 hash = 5318;
+    constexpr u64 secret0 = 0xa0761d6478bd642full;
+    constexpr u64 secret1 = 0xe7037ed1a0b428dbull;
+    constexpr u64 secret2 = 0x8ebc6af09c88c6e3ull;
+
+    u64 hash = HashMultiplyFold(CAST(u64, size) ^ secret0, secret1);
 
-    auto it = value.begin();
-    while (it != value.end())
+    i64 offset = 0;
+    for(; offset + 16 <= size; offset += 16)
     {
-        auto ch = *it;
-        hash = ((hash << 5) + hash) + ch;
-        ++it;
+        u64 a = HashRead(&data[offset], 8);
+        u64 b = HashRead(&data[offset + 8], 8);
+        hash = HashMultiplyFold(a ^ secret1, b ^ hash);
     }
 
-    return hash;
-}
+    i64 remaining = size - offset;
+    u64 a = 0;
+    u64 b = 0;
+    if(remaining > 8)
+    {
+        a = HashRead(&data[offset], 8);
+        b = HashRead(&data[offset + 8], remaining - 8);
+    }
+    else if(remaining > 0)
+    {
+        a = HashRead(&data[offset], remaining);
+    }
 
-[[maybe_unused]] INTERNAL i64 Hash(const String& value, i64 tableSize)
-{
-    return CAST(i64, Hash(value) % tableSize);
-}
\ No newline at end of file
+    hash = HashMultiplyFold(a ^ secret2, b ^ hash);
+    return HashMultiplyFold(hash ^ secret0, CAST(u64, size) ^ secret1);
+}
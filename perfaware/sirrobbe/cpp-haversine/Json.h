@@ -9,9 +9,15 @@
 struct JsonObject;
 class JsonValue;
 struct JsonToken;
+struct JsonObjectEntry;
 
 typedef List<JsonValue> JsonArray;
 
+// NOTE: Object keys are interned, every distinct key is stored once and
+//       objects refer to it by its id.
+typedef u32 JsonKey;
+constexpr JsonKey InvalidJsonKey = 0xFFFFFFFF;
+
 enum class JsonValueType
 {
     Object = 0,
@@ -53,6 +59,11 @@ INTERNAL String ParseKeyword(StringIterator* iterator, String* json);
 
 INTERNAL b32 IsLatinLetter(Rune rune);
 
+INTERNAL JsonKey InternJsonKey(const String& key);
+INTERNAL JsonKey FindJsonKey(const String& key);
+INTERNAL const String& GetJsonKeyName(JsonKey key);
+INTERNAL void FreeJsonKeys();
+
 struct JsonToken
 {
     JsonTokenType Type = JsonTokenType::Count;
@@ -60,6 +71,12 @@ struct JsonToken
     i32 Line = 0;
 };
 
+/*
+ * The members of an object are stored as a flat array of key ids and values.
+ * Objects in json documents are usually small, so looking up a member by
+ * comparing a handful of integers is faster than hashing the key, and no
+ * object has to store a copy of its keys.
+ */
 struct JsonObject
 {
     public:
@@ -68,15 +85,17 @@ struct JsonObject
 
     void Free();
 
-    void Add(String& key, JsonValue value);
+    void Add(JsonKey key, JsonValue value);
 
+    b32 ContainsKey(JsonKey key);
     b32 ContainsKey(const String& key);
 
+    JsonValue& operator[](JsonKey key);
     JsonValue& operator[](const String& key);
 
     private:
 
-    Dictionary<String, JsonValue> m_Elements;
+    List<JsonObjectEntry> m_Elements;
 };
 
 class JsonValue
@@ -100,13 +119,33 @@ public:
     };
 };
 
+struct JsonObjectEntry
+{
+    JsonKey Key;
+    JsonValue Value;
+};
+
+struct JsonKeyTable
+{
+    Dictionary<String, JsonKey> Ids;
+    List<String> Names;
+};
+
 const JsonValue JsonNullValue = {JsonValueType::Null, {nullptr}};
 
+GLOBAL JsonKeyTable s_JsonKeys;
+
+// NOTE: Returned for lookups of members that do not exist.
+GLOBAL JsonValue s_JsonMissingValue = {JsonValueType::Null, {nullptr}};
+
 INTERNAL JsonObject ParseJson(String* json)
 {
     BlockProfiler profiler("ParseJson");
 
-    List<JsonToken> tokens(256);
+    // NOTE: A token is rarely shorter than a few bytes once the separators and
+    //       whitespace around it are counted, so this usually covers the whole
+    //       document and the token list does not have to grow while lexing.
+    List<JsonToken> tokens(256 + json->Size() / 8);
 
     // NOTE(Fabian): Clear the whole token structure after parsing.
     defer({
@@ -316,7 +355,7 @@ INTERNAL JsonObject ParseJsonObject(List<JsonToken>* tokens, u64* index)
 
     for(i32 i = 0; i < elementsCount; ++i)
     {
-        String key = (*tokens)[CAST(u64, *index)].Literal->DeepCopy();
+        JsonKey key = InternJsonKey(*(*tokens)[CAST(u64, *index)].Literal);
         (*index)++;
 
         (*index)++;
@@ -552,37 +591,89 @@ INTERNAL b32 IsLatinLetter(Rune rune)
     return (rune >= 'a' && rune <= 'z') || (rune >= 'A' && rune <= 'Z');
 }
 
+INTERNAL JsonKey InternJsonKey(const String& key)
+{
+    JsonKey id = InvalidJsonKey;
+    if(s_JsonKeys.Ids.TryGet(key, id))
+    {
+        return id;
+    }
+
+    String name = key.DeepCopy();
+    id = CAST(JsonKey, s_JsonKeys.Names.Count());
+    s_JsonKeys.Names.Add(name);
+    s_JsonKeys.Ids.Add(name, id);
+    return id;
+}
+
+INTERNAL JsonKey FindJsonKey(const String& key)
+{
+    JsonKey id = InvalidJsonKey;
+    s_JsonKeys.Ids.TryGet(key, id);
+    return id;
+}
+
+[[maybe_unused]] INTERNAL const String& GetJsonKeyName(JsonKey key)
+{
+    return s_JsonKeys.Names[key];
+}
+
+INTERNAL void FreeJsonKeys()
+{
+    s_JsonKeys.Ids.Clear();
+    FREE_LIST(s_JsonKeys.Names);
+}
+
 void JsonObject::Free()
 {
-    for(auto kvp : m_Elements)
+    for(i64 i = 0; i < m_Elements.Count(); i++)
     {
-        kvp.Key->Free();
-        FreeJsonValue(kvp.Value);
+        FreeJsonValue(&m_Elements[i].Value);
     }
 
     m_Elements.Free();
 }
 
-void JsonObject::Add(String& key, JsonValue value)
+void JsonObject::Add(JsonKey key, JsonValue value)
 {
-    m_Elements.Add(key, value);
+    m_Elements.Add({key, value});
+}
+
+b32 JsonObject::ContainsKey(JsonKey key)
+{
+    for(i64 i = 0; i < m_Elements.Count(); i++)
+    {
+        if(m_Elements[i].Key == key)
+        {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 b32 JsonObject::ContainsKey(const String& key)
 {
-    return m_Elements.ContainsKey(key);
+    return ContainsKey(FindJsonKey(key));
 }
 
-JsonValue& JsonObject::operator[](const String& key)
+JsonValue& JsonObject::operator[](JsonKey key)
 {
-    if(!m_Elements.ContainsKey(key))
+    for(i64 i = 0; i < m_Elements.Count(); i++)
     {
-        // TODO(Fabi): This is hard bullshit.
-        JsonValue* val = new JsonValue{};
-        return *val;
+        if(m_Elements[i].Key == key)
+        {
+            return m_Elements[i].Value;
+        }
     }
 
-    return *m_Elements[key].Value;
+    s_JsonMissingValue = JsonNullValue;
+    return s_JsonMissingValue;
+}
+
+JsonValue& JsonObject::operator[](const String& key)
+{
+    return (*this)[FindJsonKey(key)];
 }
 
 JsonValue::operator i32() const
@@ -2,20 +2,31 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include "Core.hpp"
 
 template<typename T> class ListIterator;
 
+// NOTE: Smallest capacity a list allocates once it has to grow. Below the
+//       threshold the capacity doubles, above it it grows by half, which
+//       keeps the overhead of very large lists in check.
+constexpr i64 LIST_MIN_CAPACITY = 8;
+constexpr i64 LIST_DOUBLING_THRESHOLD = 4096;
+
 template<typename T>
 class List
 {
     friend class ListIterator<T>;
 
     public:
+    // NOTE: An empty list does not allocate, the first Add will.
     List()
     {
-        mRoot = (T*)calloc(1, sizeof(T));
-        mCapacity = 1;
+        mRoot = nullptr;
+        mCapacity = 0;
         mCount = 0;
     }
 
@@ -50,18 +61,43 @@ class List
     {
         if(mCount == mCapacity)
         {
-            ExtendCapacity(mCount * 2);
+            Grow(mCount + 1);
         }
         
         mRoot[mCount] = data;
         mCount++;
     }
 
+    void Add(T&& data)
+    {
+        if(mCount == mCapacity)
+        {
+            Grow(mCount + 1);
+        }
+        
+        mRoot[mCount] = std::move(data);
+        mCount++;
+    }
+
+    // NOTE: Constructs the element in place at the end of the list.
+    template<typename... TArgs>
+    T& Emplace(TArgs&&... args)
+    {
+        if(mCount == mCapacity)
+        {
+            Grow(mCount + 1);
+        }
+        
+        T* element = new(&mRoot[mCount]) T(std::forward<TArgs>(args)...);
+        mCount++;
+        return *element;
+    }
+
     void AddList(const List<T>& list)
     {
         if((list.Count() + this->Count()) > this->Capacity())
         {
-            ExtendCapacity(list.Count() + this->Count());
+            Grow(list.Count() + this->Count());
         }
         for(i64 i = 0; i < list.Count(); i++)
         {
@@ -105,9 +141,16 @@ class List
             if(mRoot[i] == data)
             {
                 mCount--;
-                for(i64 offset = 0; (offset + i) < mCount; offset++)
+                if constexpr(std::is_trivially_copyable_v<T>)
                 {
-                    mRoot[i + offset] = mRoot[i + offset + 1];
+                    memmove(&mRoot[i], &mRoot[i + 1], (mCount - i) * sizeof(T));
+                }
+                else
+                {
+                    for(i64 offset = 0; (offset + i) < mCount; offset++)
+                    {
+                        mRoot[i + offset] = std::move(mRoot[i + offset + 1]);
+                    }
                 }
                 
                 // NOTE(Daniel):Last Element will not be set to null as it is not accessible anymore
@@ -121,7 +164,7 @@ class List
     void RemoveUnorderedByIndex(i64 index)
     {
         assert(index >= 0 && index < mCount);
-        mRoot[index] = mRoot[mCount - 1];
+        mRoot[index] = std::move(mRoot[mCount - 1]);
         mCount--;
     }
     
@@ -138,16 +181,14 @@ class List
         return -1;
     }
 
+    // NOTE: Makes sure the list can hold at least the given amount of elements
+    //       without growing. The elements of the list are kept.
     void Reserve(i64 capacity)
     {
-        if(mRoot != nullptr)
+        if(capacity > mCapacity)
         {
-            free(mRoot);
+            ExtendCapacity(capacity);
         }
-
-        mRoot = CAST(T*, calloc(capacity, sizeof(T)));
-        mCount = 0;
-        mCapacity = capacity;
     }
 
     T& operator[](const i64 index)
@@ -179,17 +220,44 @@ class List
     
     private:
     
-    void ExtendCapacity(i64 newCapacity)
+    void Grow(i64 requiredCapacity)
     {
-        T* temp = mRoot;
+        i64 newCapacity = mCapacity < LIST_DOUBLING_THRESHOLD ? mCapacity * 2 : mCapacity + mCapacity / 2;
+        if(newCapacity < LIST_MIN_CAPACITY)
+        {
+            newCapacity = LIST_MIN_CAPACITY;
+        }
         
-        mRoot = (T*)calloc(newCapacity, sizeof(T));
+        if(newCapacity < requiredCapacity)
+        {
+            newCapacity = requiredCapacity;
+        }
         
-        for(i64 i = 0; i < mCount; i++)
+        ExtendCapacity(newCapacity);
+    }
+    
+    void ExtendCapacity(i64 newCapacity)
+    {
+        // NOTE: Elements that can be copied bytewise are moved by realloc, which
+        //       can often grow the block in place or remap its pages instead of
+        //       copying them. Only the new part has to be cleared.
+        if constexpr(std::is_trivially_copyable_v<T>)
         {
-            mRoot[i] = temp[i];
+            mRoot = CAST(T*, realloc(mRoot, newCapacity * sizeof(T)));
+            memset(REINTERPRET(void*, &mRoot[mCapacity]), 0, (newCapacity - mCapacity) * sizeof(T));
+        }
+        else
+        {
+            T* temp = mRoot;
+            
+            mRoot = (T*)calloc(newCapacity, sizeof(T));
+            
+            for(i64 i = 0; i < mCount; i++)
+            {
+                mRoot[i] = std::move(temp[i]);
+            }
+            free(temp);
         }
-        free(temp);
         
         mCapacity = newCapacity;
     }
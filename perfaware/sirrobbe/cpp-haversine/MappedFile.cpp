@@ -0,0 +1,109 @@
+#include "MappedFile.hpp"
+
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile MapFile(const char* name)
+{
+    MappedFile result = {};
+
+    HANDLE file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        printf("Failed to open the file %s\n", name);
+        return result;
+    }
+
+    LARGE_INTEGER size = {};
+    GetFileSizeEx(file, &size);
+
+    // NOTE: The view stays valid after both handles are closed.
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(mapping != nullptr)
+    {
+        result.Data = REINTERPRET(byte*, MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if(result.Data != nullptr)
+        {
+            result.Size = CAST(u64, size.QuadPart);
+        }
+
+        CloseHandle(mapping);
+    }
+
+    CloseHandle(file);
+
+    if(result.Data == nullptr)
+    {
+        printf("Failed to map the file %s\n", name);
+    }
+
+    return result;
+}
+
+void UnmapFile(MappedFile* file)
+{
+    if(file->Data != nullptr)
+    {
+        UnmapViewOfFile(file->Data);
+    }
+
+    *file = {};
+}
+
+#else
+
+MappedFile MapFile(const char* name)
+{
+    MappedFile result = {};
+
+    i32 file = open(name, O_RDONLY);
+    if(file < 0)
+    {
+        printf("Failed to open the file %s\n", name);
+        return result;
+    }
+
+    struct stat status = {};
+    if(fstat(file, &status) == 0 && status.st_size > 0)
+    {
+        // NOTE: MAP_POPULATE faults all pages in here, otherwise the page faults would
+        //       show up in whatever block touches the data first.
+        void* data = mmap(nullptr, CAST(size_t, status.st_size), PROT_READ, MAP_PRIVATE | MAP_POPULATE, file, 0);
+        if(data != MAP_FAILED)
+        {
+            result.Data = REINTERPRET(byte*, data);
+            result.Size = CAST(u64, status.st_size);
+        }
+    }
+
+    close(file);
+
+    if(result.Data == nullptr)
+    {
+        printf("Failed to map the file %s\n", name);
+    }
+
+    return result;
+}
+
+void UnmapFile(MappedFile* file)
+{
+    if(file->Data != nullptr)
+    {
+        munmap(file->Data, file->Size);
+    }
+
+    *file = {};
+}
+
+#endif
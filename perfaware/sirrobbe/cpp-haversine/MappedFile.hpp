@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Core.hpp"
+
+/*
+ * A whole file mapped read-only into memory. The data is never copied, the
+ * pages come straight from the file cache.
+ */
+struct MappedFile
+{
+    byte* Data;
+    u64 Size;
+};
+
+INTERNAL MappedFile MapFile(const char* name);
+INTERNAL void UnmapFile(MappedFile* file);
@@ -1,17 +1,29 @@
-#include <vector>
+#include <cstdint>
 #include "Profiling.h"
 #include "Timing.hpp"
 
 namespace Profiling
 {
-    std::vector<BlockStats> Blocks;
+    ProfileAnchor Anchors[MAX_PROFILE_ANCHORS];
+    u32 AnchorOrder[MAX_PROFILE_ANCHORS];
+    u32 AnchorCount = 0;
+    u32 CurrentParent = 0;
+
     u64 SessionStart = 0;
     u64 SessionEnd = 0;
     u64 SessionLength = 0;
 
     static void Begin()
     {
-        Blocks.clear();
+        // NOTE: The names stay, call sites that cached their slot index keep it.
+        for(u32 index = 0; index < MAX_PROFILE_ANCHORS; index++)
+        {
+            Anchors[index].ExclusiveTime = 0;
+            Anchors[index].InclusiveTime = 0;
+            Anchors[index].HitCount = 0;
+        }
+
+        CurrentParent = 0;
         SessionStart = GetCpuTime();
     }
 
@@ -28,24 +40,92 @@ namespace Profiling
         f64 totalMs = (static_cast<f64>(SessionLength) / cpuFrequency) * 1000;
         printf("\nTotal time: %fms (%fGHz)\n", totalMs, speedInGHz);
 
-        for(i32 index = 0; index < Blocks.size(); index++)
+        for(u32 index = 0; index < AnchorCount; index++)
+        {
+            ProfileAnchor* anchor = &Anchors[AnchorOrder[index]];
+            if(anchor->HitCount == 0)
+            {
+                continue;
+            }
+
+            f64 percentage = (static_cast<f64>(anchor->ExclusiveTime) / static_cast<f64>(SessionLength)) * 100.0;
+            printf("Block '%s'[%llu]: %llu (%.2f%%",
+                   anchor->Name,
+                   static_cast<unsigned long long>(anchor->HitCount),
+                   static_cast<unsigned long long>(anchor->ExclusiveTime),
+                   percentage);
+
+            if(anchor->InclusiveTime != anchor->ExclusiveTime)
+            {
+                f64 inclusivePercentage = (static_cast<f64>(anchor->InclusiveTime) / static_cast<f64>(SessionLength)) * 100.0;
+                printf(", %.2f%% w/children", inclusivePercentage);
+            }
+
+            printf(")\n");
+        }
+    }
+
+    // NOTE: Open addressing on the pointer value. Only runs when a block is entered
+    //       by name, PROFILE_BLOCK calls it once per call site. When every slot is
+    //       taken the block falls back to slot 0, which is never printed.
+    static u32 GetAnchorIndex(const char* name)
+    {
+        constexpr u32 mask = MAX_PROFILE_ANCHORS - 1;
+
+        u64 key = static_cast<u64>(reinterpret_cast<uintptr_t>(name));
+        u32 index = static_cast<u32>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+
+        for(u32 probe = 0; probe < MAX_PROFILE_ANCHORS; probe++)
         {
-            auto block = Blocks[index];
-            u64 delta = block.End - block.Start;
-            f64 percentage = (static_cast<f64>(delta) / static_cast<f64>(SessionLength)) * 100.0;
-            printf("Block '%s': %lld (%.2f%%)\n", block.Name.c_str(), delta, percentage);
-        }  
+            if(index != 0)
+            {
+                ProfileAnchor* anchor = &Anchors[index];
+                if(anchor->Name == name)
+                {
+                    return index;
+                }
+
+                if(anchor->Name == nullptr)
+                {
+                    anchor->Name = name;
+                    AnchorOrder[AnchorCount++] = index;
+                    return index;
+                }
+            }
+
+            index = (index + 1) & mask;
+        }
+
+        return 0;
     }
 }
 
-BlockProfiler::BlockProfiler(std::string name) : 
-  Start(GetCpuTime()),
-  End(0),
-  Name(name)
+BlockProfiler::BlockProfiler(const char* name) :
+  BlockProfiler(Profiling::GetAnchorIndex(name))
 {}
 
+BlockProfiler::BlockProfiler(u32 anchorIndex) :
+  Start(0),
+  OldInclusiveTime(Profiling::Anchors[anchorIndex].InclusiveTime),
+  AnchorIndex(anchorIndex),
+  ParentIndex(Profiling::CurrentParent)
+{
+    Profiling::CurrentParent = anchorIndex;
+    Start = GetCpuTime();
+}
+
 BlockProfiler::~BlockProfiler()
 {
-    End = GetCpuTime();
-    Profiling::Blocks.push_back({Start, End, Name});
+    u64 elapsed = GetCpuTime() - Start;
+    Profiling::CurrentParent = ParentIndex;
+
+    ProfileAnchor* parent = &Profiling::Anchors[ParentIndex];
+    ProfileAnchor* anchor = &Profiling::Anchors[AnchorIndex];
+
+    // NOTE: Restoring the old inclusive time instead of adding keeps recursive
+    //       blocks from counting their time twice.
+    parent->ExclusiveTime -= elapsed;
+    anchor->ExclusiveTime += elapsed;
+    anchor->InclusiveTime = OldInclusiveTime + elapsed;
+    anchor->HitCount++;
 }
@@ -1,30 +1,52 @@
 #pragma once
 
-#include <string>
-#include "Types.h"
+#include "Core.hpp"
+
+/*
+ * Every distinct block name gets one fixed anchor slot that sums up the hit
+ * count and the exclusive and inclusive time of all blocks with that name.
+ * Names are keyed by pointer, so they have to be string literals (or live
+ * at least as long as the profiling session). Nothing is allocated while
+ * profiling, a block costs two timer reads and a handful of adds.
+ */
+
+// NOTE: Must be a power of two, slot 0 is reserved for "no parent".
+constexpr u32 MAX_PROFILE_ANCHORS = 256;
+
+struct ProfileAnchor
+{
+    const char* Name;
+    u64 ExclusiveTime;
+    u64 InclusiveTime;
+    u64 HitCount;
+};
 
 namespace Profiling
 {
     static void Begin();
     static void End();
     static void PrintBlocks();
-} 
-
-struct BlockStats
-{
-    u64 Start;
-    u64 End;
-    std::string Name;
-};
+    static u32 GetAnchorIndex(const char* name);
+}
 
 class BlockProfiler
 {
     public:
-    BlockProfiler(std::string name);
+    BlockProfiler(const char* name);
+    BlockProfiler(u32 anchorIndex);
     ~BlockProfiler();
 
     u64 Start;
-    u64 End;
-    std::string Name;
+    u64 OldInclusiveTime;
+    u32 AnchorIndex;
+    u32 ParentIndex;
 };
 
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// NOTE: Looks the slot up once per call site instead of on every entry, for blocks
+//       inside hot loops.
+#define PROFILE_BLOCK(name) \
+    static const u32 PROFILE_CONCAT(profileAnchor, __LINE__) = Profiling::GetAnchorIndex(name); \
+    BlockProfiler PROFILE_CONCAT(profileBlock, __LINE__)(PROFILE_CONCAT(profileAnchor, __LINE__))
@@ -1,18 +1,27 @@
 #include <stdarg.h>
 
+#include <bit>
 #include <cmath>
+#include <immintrin.h>
 
 String::String()
 {
     mData = 0;
     mLength = 0;
     mSize = 0;
+    mIsAscii = true;
+    mCodepointOffsets = nullptr;
+    mHash = 0;
+    mIsHashed = false;
 }
 
 String::String(byte* bytes, u64 size)
 {
     mSize = size;
     mData = REINTERPRET(byte*, malloc(mSize + 1));
+    mCodepointOffsets = nullptr;
+    mHash = 0;
+    mIsHashed = false;
     
     for(u64 i = 0; i < size; i++)
     {
@@ -27,6 +36,9 @@ String::String(char* string)
 {
    
     mData = reinterpret_cast<u8*>(string);    
+    mCodepointOffsets = nullptr;
+    mHash = 0;
+    mIsHashed = false;
     DetermineLength();
 }
 
@@ -43,11 +55,25 @@ String::String(Rune rune)
 void String::Free()
 {
     free(mData);
+    free(mCodepointOffsets);
     mData = nullptr;
+    mCodepointOffsets = nullptr;
+    mIsHashed = false;
     mSize = -1;
     mLength = -1;
 }
 
+u64 String::Hash() const
+{
+    if(!mIsHashed)
+    {
+        mHash = HashBytes(mData, mSize);
+        mIsHashed = true;
+    }
+
+    return mHash;
+}
+
 String String::DeepCopy() const
 {
     return String(mData, mSize);
@@ -60,12 +86,22 @@ i64 String::FirstIndexOf(Rune rune) const
 
 i64 String::FirstIndexOf(Rune rune, i64 start) const
 {
-    StringIterator iterator = begin();
-    
-    for(i64 i = 0; i < start; i++)
+    i64 startOffset = GetByteOffsetOfIndex(start);
+
+    // NOTE: An ASCII byte can never be part of a multi-byte codepoint, so for
+    //       ASCII runes a plain byte search finds the correct codepoint.
+    if(rune < 0x80)
     {
-        ++iterator;
+        i64 offset = FindFirstByte(&mData[startOffset], mSize - startOffset, CAST(byte, rune), true);
+        if(offset == -1)
+        {
+            return -1;
+        }
+
+        return start + (mIsAscii ? offset : CountCodepoints(&mData[startOffset], offset));
     }
+
+    StringIterator iterator(this, startOffset, start);
     
     while(iterator != end())
     {
@@ -82,8 +118,21 @@ i64 String::FirstIndexOf(Rune rune, i64 start) const
 
 i64 String::LastIndexOf(Rune rune) const
 {
-    for(StringIterator it = end(); it != begin(); --it)
+    if(rune < 0x80)
+    {
+        i64 offset = FindLastByte(mData, mSize, CAST(byte, rune), true);
+        if(offset == -1 || mIsAscii)
+        {
+            return offset;
+        }
+
+        return CountCodepoints(mData, offset);
+    }
+
+    StringIterator it = end();
+    while(it != begin())
     {
+        --it;
         if(*it == rune)
         {
             return it.Index();
@@ -157,8 +206,23 @@ Rune String::GetCodepointAtByteOffset(u64 offset) const
 
 i64 String::GetByteOffsetOfIndex(i64 index) const
 {
+    if(mIsAscii)
+    {
+        return index;
+    }
+
+    // NOTE: Start from the closest known offset in front of the index, if the
+    //       string is long enough to have a table. Otherwise we have to walk
+    //       from the beginning, which is at most CODEPOINT_OFFSET_STRIDE steps.
     i64 offset = 0;
-    for(i64 i = 0; i < index; i++)
+    i64 i = 0;
+    if(mCodepointOffsets != nullptr && index < mLength)
+    {
+        offset = mCodepointOffsets[index / CODEPOINT_OFFSET_STRIDE];
+        i = index - (index % CODEPOINT_OFFSET_STRIDE);
+    }
+
+    for(; i < index; i++)
     {
         offset += GetCodepointSize(offset);
     }
@@ -231,6 +295,11 @@ String String::Concat(char character) const
 String String::Substring(u64 startIndex, u64 length) const
 {
     i64 startOffset = GetByteOffsetOfIndex(CAST(i64, startIndex));
+    if(mIsAscii)
+    {
+        return String(&mData[startOffset], length);
+    }
+
     auto it = StringIterator(this, startOffset, startIndex);
     for(i32 i = 0; i < length; i++)
     {
@@ -254,34 +323,24 @@ bool String::EndsWith(Rune val) const
 
 bool String::Contains(Rune val) const
 {
+    if(val < 0x80)
+    {
+        return FindFirstByte(mData, mSize, CAST(byte, val), true) != -1;
+    }
+
     return FirstIndexOf(val) != -1;
 }
 
 String String::Trim()
 {
-    StringIterator start = begin();
-    if(StartsWith(' '))
-    {
-        while(*start == ' ')
-        {
-            ++start;
-        }
-    }
-    
-    StringIterator endIt = end();
-    // Move one back to get to actual last symbol
-    --endIt;
-    if(EndsWith(' '))
+    i64 start = FindFirstByte(mData, mSize, ' ', false);
+    if(start == -1)
     {
-        while(*endIt == ' ')
-        {
-            --endIt;
-        }
+        return String(mData, 0);
     }
-    // + 1 step to redeem the one we did in the previous step
-    ++endIt;
-    
-    return String(&mData[start.Offset()], endIt.Offset() - start.Offset());
+
+    i64 last = FindLastByte(mData, mSize, ' ', false);
+    return String(&mData[start], last + 1 - start);
 }
 
 Rune String::operator[](i64 index) const
@@ -303,6 +362,7 @@ void String::DetermineLength()
 {
     mLength = 0;
     mSize = 0;
+    mIsAscii = true;
     while(mData[mSize] != '\0')
     {
         mLength++;
@@ -315,9 +375,32 @@ void String::DetermineLength()
         }
         else
         {
+            mIsAscii &= (size == 1);
             mSize += size;
         }
     }
+
+    if(!mIsAscii && mLength > CODEPOINT_OFFSET_STRIDE)
+    {
+        BuildCodepointOffsets();
+    }
+}
+
+void String::BuildCodepointOffsets()
+{
+    i64 entryCount = (mLength + CODEPOINT_OFFSET_STRIDE - 1) / CODEPOINT_OFFSET_STRIDE;
+    mCodepointOffsets = CAST(i64*, malloc(entryCount * sizeof(i64)));
+
+    i64 offset = 0;
+    for(i64 index = 0; index < mLength; index++)
+    {
+        if((index % CODEPOINT_OFFSET_STRIDE) == 0)
+        {
+            mCodepointOffsets[index / CODEPOINT_OFFSET_STRIDE] = offset;
+        }
+
+        offset += GetCodepointSize(offset);
+    }
 }
 
 int String::GetCodepointSize(u64 index) const
@@ -384,6 +467,161 @@ ScopedString::ScopedString(String string)
     mData = REINTERPRET(ScopedString*, &string)->mData;
     mLength = REINTERPRET(ScopedString*, &string)->mLength;
     mSize = REINTERPRET(ScopedString*, &string)->mSize;   
+    mIsAscii = REINTERPRET(ScopedString*, &string)->mIsAscii;
+    mCodepointOffsets = REINTERPRET(ScopedString*, &string)->mCodepointOffsets;
+    mHash = REINTERPRET(ScopedString*, &string)->mHash;
+    mIsHashed = REINTERPRET(ScopedString*, &string)->mIsHashed;
+}
+
+// NOTE: The byte helpers below process 32 bytes per step when compiled with AVX2
+//       and 16 bytes with SSE2, which every x64 CPU supports. The remaining tail
+//       is handled one byte at a time, so no read goes past the given size.
+b32 BytesEqual(const byte* a, const byte* b, i64 size)
+{
+    i64 offset = 0;
+
+#if defined(__AVX2__)
+    for(; offset + 32 <= size; offset += 32)
+    {
+        __m256i blockA = _mm256_loadu_si256(REINTERPRET(const __m256i*, &a[offset]));
+        __m256i blockB = _mm256_loadu_si256(REINTERPRET(const __m256i*, &b[offset]));
+        if(CAST(u32, _mm256_movemask_epi8(_mm256_cmpeq_epi8(blockA, blockB))) != 0xFFFFFFFF)
+        {
+            return false;
+        }
+    }
+#endif
+
+    for(; offset + 16 <= size; offset += 16)
+    {
+        __m128i blockA = _mm_loadu_si128(REINTERPRET(const __m128i*, &a[offset]));
+        __m128i blockB = _mm_loadu_si128(REINTERPRET(const __m128i*, &b[offset]));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(blockA, blockB)) != 0xFFFF)
+        {
+            return false;
+        }
+    }
+
+    for(; offset < size; offset++)
+    {
+        if(a[offset] != b[offset])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// NOTE: Returns the offset of the first byte that is equal to value if match is
+//       set, otherwise the offset of the first byte that differs from it. -1 if
+//       there is no such byte.
+i64 FindFirstByte(const byte* data, i64 size, byte value, b32 match)
+{
+    i64 offset = 0;
+
+#if defined(__AVX2__)
+    __m256i wideNeedle = _mm256_set1_epi8(CAST(char, value));
+    u32 wideFlip = match ? 0 : 0xFFFFFFFF;
+    for(; offset + 32 <= size; offset += 32)
+    {
+        __m256i block = _mm256_loadu_si256(REINTERPRET(const __m256i*, &data[offset]));
+        u32 mask = CAST(u32, _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, wideNeedle))) ^ wideFlip;
+        if(mask != 0)
+        {
+            return offset + std::countr_zero(mask);
+        }
+    }
+#endif
+
+    __m128i needle = _mm_set1_epi8(CAST(char, value));
+    u32 flip = match ? 0 : 0xFFFF;
+    for(; offset + 16 <= size; offset += 16)
+    {
+        __m128i block = _mm_loadu_si128(REINTERPRET(const __m128i*, &data[offset]));
+        u32 mask = CAST(u32, _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle))) ^ flip;
+        if(mask != 0)
+        {
+            return offset + std::countr_zero(mask);
+        }
+    }
+
+    for(; offset < size; offset++)
+    {
+        if((data[offset] == value) == (match != 0))
+        {
+            return offset;
+        }
+    }
+
+    return -1;
+}
+
+// NOTE: Same as FindFirstByte, but searches from the end of the data.
+i64 FindLastByte(const byte* data, i64 size, byte value, b32 match)
+{
+    i64 end = size;
+
+#if defined(__AVX2__)
+    __m256i wideNeedle = _mm256_set1_epi8(CAST(char, value));
+    u32 wideFlip = match ? 0 : 0xFFFFFFFF;
+    for(; end >= 32; end -= 32)
+    {
+        __m256i block = _mm256_loadu_si256(REINTERPRET(const __m256i*, &data[end - 32]));
+        u32 mask = CAST(u32, _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, wideNeedle))) ^ wideFlip;
+        if(mask != 0)
+        {
+            return end - 1 - std::countl_zero(mask);
+        }
+    }
+#endif
+
+    __m128i needle = _mm_set1_epi8(CAST(char, value));
+    u32 flip = match ? 0 : 0xFFFF;
+    for(; end >= 16; end -= 16)
+    {
+        __m128i block = _mm_loadu_si128(REINTERPRET(const __m128i*, &data[end - 16]));
+        u32 mask = CAST(u32, _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle))) ^ flip;
+        if(mask != 0)
+        {
+            // NOTE: The mask only uses the lower 16 bits.
+            return end - 1 - (std::countl_zero(mask) - 16);
+        }
+    }
+
+    for(; end > 0; end--)
+    {
+        if((data[end - 1] == value) == (match != 0))
+        {
+            return end - 1;
+        }
+    }
+
+    return -1;
+}
+
+// NOTE: Counts every byte that starts a codepoint, i.e. every byte that is not a
+//       continuation byte of the form 0b10xxxxxx. As signed bytes the continuation
+//       bytes are exactly the range [-128, -65].
+i64 CountCodepoints(const byte* data, i64 size)
+{
+    i64 count = 0;
+    i64 offset = 0;
+
+    __m128i lastContinuation = _mm_set1_epi8(-65);
+    for(; offset + 16 <= size; offset += 16)
+    {
+        __m128i block = _mm_loadu_si128(REINTERPRET(const __m128i*, &data[offset]));
+        u32 mask = CAST(u32, _mm_movemask_epi8(_mm_cmpgt_epi8(block, lastContinuation)));
+        count += std::popcount(mask);
+    }
+
+    for(; offset < size; offset++)
+    {
+        count += (data[offset] & 0b11000000) != 0b10000000;
+    }
+
+    return count;
 }
 
 int GetCodepointUTF8Size(Rune rune)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Core.hpp"
+#include "HashFunctions.hpp"
 #include "List.hpp"
 
 #include <cstdlib>
@@ -9,11 +10,23 @@ class String;
 class UTF16String;
 class StringIterator;
 
+// NOTE: Distance in codepoints between two entries of the byte offset table
+//       of non-ASCII strings.
+constexpr i64 CODEPOINT_OFFSET_STRIDE = 64;
+
 b32 operator==(const String& a, const String& b);
 b32 operator!=(const String& a, const String& b);
 
 INTERNAL void Free(String* string);
 
+INTERNAL u64 Hash(const String& value);
+INTERNAL i64 Hash(const String& value, i64 tableSize);
+
+INTERNAL b32 BytesEqual(const byte* a, const byte* b, i64 size);
+INTERNAL i64 FindFirstByte(const byte* data, i64 size, byte value, b32 match);
+INTERNAL i64 FindLastByte(const byte* data, i64 size, byte value, b32 match);
+INTERNAL i64 CountCodepoints(const byte* data, i64 size);
+
 /*
  * The base string type of the engine.
  * 
@@ -39,6 +52,19 @@ INTERNAL void Free(String* string);
  * not own the memory should be a const String or const pointer to a string.
  * Using this style does prohibit these objects access to the Free() method.
  * That way the compiler can help to enforce the correct string ownership
+ * 
+ * Indexing:
+ * Because of the variable codepoint size of UTF-8 a codepoint index can not
+ * be mapped to a byte offset directly. To avoid scanning the whole string
+ * on every access, a string remembers whether it is pure ASCII, in which case
+ * index and byte offset are the same. Longer strings that contain multi-byte
+ * codepoints additionally store the byte offset of every 64th codepoint, so
+ * an index lookup only has to walk at most 63 codepoints. This table is owned
+ * by the string and released together with its data in Free().
+ * 
+ * Hashing:
+ * The hash of a string is computed on first use and then cached, so strings
+ * used as dictionary keys or for repeated lookups are only hashed once.
  */
 class String
 {
@@ -103,15 +129,23 @@ class String
     
     Rune operator[](i64 index) const;
 
+    b32 IsAscii() const { return mIsAscii; }
+    u64 Hash() const;
+
     protected:
     
     byte* mData;
     i64 mSize;
     i64 mLength;
+    i64* mCodepointOffsets;
+    mutable u64 mHash;
+    b32 mIsAscii;
+    mutable b32 mIsHashed;
     
     private:
     
     void DetermineLength();
+    void BuildCodepointOffsets();
     int GetCodepointSize(u64 index) const;
 };
 
@@ -167,23 +201,11 @@ b32 operator==(const String& a, const String& b)
 {
     if(a.Size() != b.Size()) { return false; }
 
-    StringIterator itA = a.begin();
-    StringIterator itB = b.begin();
-
-    for(i64 i = 0; i < a.Length(); i++)
-    {
-        Rune runeA = *itA;
-        Rune runeB = *itB;
-        if(runeA != runeB)
-        {
-            return false;
-        }
-
-        ++itA;
-        ++itB;
-    }
-
-    return true;
+    // NOTE: UTF-8 encodes every codepoint in exactly one way, so two strings
+    //       contain the same codepoints if and only if their bytes are equal.
+    return BytesEqual(REINTERPRET(const byte*, a.AsCString()),
+                      REINTERPRET(const byte*, b.AsCString()),
+                      a.Size());
 }
 
 b32 operator!=(const String& a, const String& b)
@@ -198,6 +220,16 @@ b32 operator!=(const String& a, const String& b)
     string->Free();
 }
 
+[[maybe_unused]] INTERNAL u64 Hash(const String& value)
+{
+    return value.Hash();
+}
+
+[[maybe_unused]] INTERNAL i64 Hash(const String& value, i64 tableSize)
+{
+    return CAST(i64, Hash(value) % tableSize);
+}
+
 String String::SubstringByOffset(i64 start, i64 end) const
 {
     return String(&mData[start], end - start);
@@ -0,0 +1,227 @@
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cstdio>
+
+#include "String.hpp"
+#include "Timing.cpp"
+
+/*
+ * Microbenchmark for the SIMD string primitives. Every operation is measured
+ * against the codepoint-by-codepoint iterator implementation the String class
+ * used before, on a short key-sized string and on a long string. Each test is
+ * repeated and the fastest run is reported, since that is the run with the
+ * least noise from the OS and cold caches.
+ */
+
+constexpr i32 RepetitionCount = 64;
+
+static b32 ReferenceEquals(const String& a, const String& b);
+static i64 ReferenceFirstIndexOf(const String& string, Rune rune);
+static i64 ReferenceLastIndexOf(const String& string, Rune rune);
+static String ReferenceTrim(const String& string);
+
+// NOTE: The volatile sink keeps the compiler from removing the measured calls.
+static volatile i64 s_Sink = 0;
+
+template<typename T> static u64 MeasureMinimum(T function)
+{
+  u64 minimum = U64_MAX;
+  for(i32 repetition = 0; repetition < RepetitionCount; repetition++)
+  {
+    u64 start = GetCpuTime();
+    s_Sink = s_Sink + function();
+    u64 elapsed = GetCpuTime() - start;
+
+    if(elapsed < minimum)
+    {
+      minimum = elapsed;
+    }
+  }
+
+  return minimum;
+}
+
+template<typename TReference, typename TSimd>
+static void Compare(const char* name, const String& string, TReference reference, TSimd simd)
+{
+  u64 referenceCycles = MeasureMinimum(reference);
+  u64 simdCycles = MeasureMinimum(simd);
+  f64 speedup = static_cast<f64>(referenceCycles) / static_cast<f64>(simdCycles ? simdCycles : 1);
+
+  printf("%-14s %10lld bytes: reference %12llu cycles, simd %12llu cycles (%.2fx)\n",
+         name,
+         static_cast<long long>(string.Size()),
+         static_cast<unsigned long long>(referenceCycles),
+         static_cast<unsigned long long>(simdCycles),
+         speedup);
+}
+
+static void RunBenchmarks(const char* title, String* string, String* copy)
+{
+  printf("\n%s\n", title);
+
+  Compare(
+    "operator==",
+    *string,
+    [&]() { return static_cast<i64>(ReferenceEquals(*string, *copy)); },
+    [&]() { return static_cast<i64>(*string == *copy); });
+
+  Compare(
+    "FirstIndexOf",
+    *string,
+    [&]() { return ReferenceFirstIndexOf(*string, '#'); },
+    [&]() { return string->FirstIndexOf('#'); });
+
+  Compare(
+    "Contains",
+    *string,
+    [&]() { return static_cast<i64>(ReferenceFirstIndexOf(*string, '#') != -1); },
+    [&]() { return static_cast<i64>(string->Contains('#')); });
+
+  Compare(
+    "LastIndexOf",
+    *string,
+    [&]() { return ReferenceLastIndexOf(*string, '!'); },
+    [&]() { return string->LastIndexOf('!'); });
+
+  Compare(
+    "Trim",
+    *string,
+    [&]()
+    {
+      String trimmed = ReferenceTrim(*string);
+      i64 size = trimmed.Size();
+      trimmed.Free();
+      return size;
+    },
+    [&]()
+    {
+      String trimmed = string->Trim();
+      i64 size = trimmed.Size();
+      trimmed.Free();
+      return size;
+    });
+}
+
+static String MakeTestString(i64 size)
+{
+  // NOTE: Spaces on both ends so Trim has work to do, the searched runes are
+  //       only at the far end from where the search starts.
+  byte* bytes = static_cast<byte*>(malloc(size));
+  for(i64 index = 0; index < size; index++)
+  {
+    bytes[index] = static_cast<byte>('a' + (index % 26));
+  }
+
+  bytes[0] = ' ';
+  bytes[1] = '!';
+  bytes[size - 2] = '#';
+  bytes[size - 1] = ' ';
+
+  String string(bytes, static_cast<u64>(size));
+  free(bytes);
+  return string;
+}
+
+i32 main()
+{
+  printf("Estimating CPU frequency...\n");
+  f64 frequencyInGHz = static_cast<f64>(GetCpuFrequency()) / (1000.0 * 1000.0 * 1000.0);
+  printf("CPU frequency: %.2fGHz\n", frequencyInGHz);
+
+#if defined(__AVX2__)
+  printf("Compiled with AVX2\n");
+#else
+  printf("Compiled with SSE2\n");
+#endif
+
+  String shortString = MakeTestString(12);
+  String shortCopy = shortString.DeepCopy();
+  RunBenchmarks("Short string", &shortString, &shortCopy);
+
+  String longString = MakeTestString(1024 * 1024);
+  String longCopy = longString.DeepCopy();
+  RunBenchmarks("Long string", &longString, &longCopy);
+
+  shortString.Free();
+  shortCopy.Free();
+  longString.Free();
+  longCopy.Free();
+
+  return 0;
+}
+
+// NOTE: The reference implementations are the iterator based versions the String
+//       class used before the SIMD paths were added.
+static b32 ReferenceEquals(const String& a, const String& b)
+{
+  if(a.Size() != b.Size())
+  {
+    return false;
+  }
+
+  StringIterator itA = a.begin();
+  StringIterator itB = b.begin();
+
+  for(i64 i = 0; i < a.Length(); i++)
+  {
+    if(*itA != *itB)
+    {
+      return false;
+    }
+
+    ++itA;
+    ++itB;
+  }
+
+  return true;
+}
+
+static i64 ReferenceFirstIndexOf(const String& string, Rune rune)
+{
+  StringIterator iterator = string.begin();
+  while(iterator != string.end())
+  {
+    if(*iterator == rune)
+    {
+      return static_cast<i64>(iterator.Index());
+    }
+
+    ++iterator;
+  }
+
+  return -1;
+}
+
+static i64 ReferenceLastIndexOf(const String& string, Rune rune)
+{
+  for(StringIterator it = string.end(); it != string.begin(); --it)
+  {
+    if(*it == rune)
+    {
+      return static_cast<i64>(it.Index());
+    }
+  }
+
+  return -1;
+}
+
+static String ReferenceTrim(const String& string)
+{
+  StringIterator start = string.begin();
+  while(*start == ' ')
+  {
+    ++start;
+  }
+
+  StringIterator endIt = string.end();
+  --endIt;
+  while(*endIt == ' ')
+  {
+    --endIt;
+  }
+  ++endIt;
+
+  String result = string.SubstringByOffset(static_cast<i64>(start.Offset()), static_cast<i64>(endIt.Offset()));
+  return result;
+}
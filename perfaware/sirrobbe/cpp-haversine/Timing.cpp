@@ -1,30 +1,181 @@
 #include "Timing.hpp"
+#include "Core.hpp"
 
+#if defined(_WIN32)
 #include <intrin.h>
 #include <Windows.h>
+#else
+#include <cstdio>
+#include <cpuid.h>
+#include <time.h>
+#include <x86intrin.h>
+#endif
 
-u64 GetCpuTime()
+/*
+ * The CPU time is the TSC on every platform. Only the CPUID wrapper and the
+ * OS timer the TSC gets calibrated against differ: QueryPerformanceCounter on
+ * Windows and CLOCK_MONOTONIC_RAW on Linux. The raw clock is not slewed by
+ * NTP, so it ticks at the same rate as the TSC.
+ */
+
+#if defined(_WIN32)
+
+static void ReadCpuid(u32 leaf, u32* registers)
 {
-    return __rdtsc();
+    i32 values[4] = {};
+    __cpuid(values, CAST(i32, leaf));
+    for(i32 index = 0; index < 4; index++)
+    {
+        registers[index] = CAST(u32, values[index]);
+    }
 }
 
-u64 GetCpuFrequency()
+static u64 GetOsTimerFrequency()
 {
     LARGE_INTEGER frequency = {};
     QueryPerformanceFrequency(&frequency);
+    return CAST(u64, frequency.QuadPart);
+}
 
-    u64 start = GetCpuTime();
+static u64 GetOsTime()
+{
+    LARGE_INTEGER counter = {};
+    QueryPerformanceCounter(&counter);
+    return CAST(u64, counter.QuadPart);
+}
+
+// NOTE: Windows does not report the frequency it uses for the TSC anywhere.
+static u64 GetCpuFrequencyFromOs()
+{
+    return 0;
+}
+
+#else
+
+static void ReadCpuid(u32 leaf, u32* registers)
+{
+    __cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+}
+
+static u64 GetOsTimerFrequency()
+{
+    return 1000 * 1000 * 1000;
+}
+
+static u64 GetOsTime()
+{
+    timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+    return CAST(u64, time.tv_sec) * GetOsTimerFrequency() + CAST(u64, time.tv_nsec);
+}
 
-    LARGE_INTEGER performanceCounterStart = {};
-    LARGE_INTEGER performanceCounterEnd = {};
-    QueryPerformanceCounter(&performanceCounterStart);
+// NOTE: Mainline kernels keep tsc_khz to themselves, but some kernels export it here.
+static u64 GetCpuFrequencyFromOs()
+{
+    FILE* file = fopen("/sys/devices/system/cpu/cpu0/tsc_freq_khz", "rb");
+    if(file == nullptr)
+    {
+        return 0;
+    }
 
-    while((performanceCounterEnd.QuadPart - performanceCounterStart.QuadPart)
-        < frequency.QuadPart)
+    unsigned long long kiloHertz = 0;
+    if(fscanf(file, "%llu", &kiloHertz) != 1)
     {
-        QueryPerformanceCounter(&performanceCounterEnd);
+        kiloHertz = 0;
+    }
+
+    fclose(file);
+    return CAST(u64, kiloHertz) * 1000;
+}
+
+#endif
+
+u64 GetCpuTime()
+{
+    return __rdtsc();
+}
+
+// NOTE: Returns 0 when the CPU does not report the TSC frequency. Leaf 0x15 gives
+//       the TSC to crystal ratio and usually the crystal frequency, when the crystal
+//       is missing the base frequency from leaf 0x16 is what the TSC runs at.
+static u64 GetCpuFrequencyFromCpuid()
+{
+    u32 registers[4] = {};
+    ReadCpuid(0, registers);
+    u32 maxLeaf = registers[0];
+
+    if(maxLeaf < 0x15)
+    {
+        return 0;
+    }
+
+    ReadCpuid(0x15, registers);
+    u64 denominator = registers[0];
+    u64 numerator = registers[1];
+    u64 crystalFrequency = registers[2];
+
+    if(denominator == 0 || numerator == 0)
+    {
+        return 0;
+    }
+
+    if(crystalFrequency != 0)
+    {
+        return crystalFrequency * numerator / denominator;
+    }
+
+    if(maxLeaf >= 0x16)
+    {
+        ReadCpuid(0x16, registers);
+        u64 baseMHz = registers[0] & 0xFFFF;
+        return baseMHz * 1000 * 1000;
+    }
+
+    return 0;
+}
+
+// NOTE: 10ms against the OS timer is already accurate to about a part per million,
+//       so there is no need to wait a full second.
+static u64 CalibrateCpuFrequency()
+{
+    constexpr u64 calibrationMilliseconds = 10;
+
+    u64 osFrequency = GetOsTimerFrequency();
+    u64 waitTicks = osFrequency * calibrationMilliseconds / 1000;
+
+    u64 osStart = GetOsTime();
+    u64 start = GetCpuTime();
+
+    u64 osEnd = osStart;
+    while((osEnd - osStart) < waitTicks)
+    {
+        osEnd = GetOsTime();
     }
 
     u64 end = GetCpuTime();
-    return end - start;
+
+    f64 elapsedSeconds = CAST(f64, osEnd - osStart) / CAST(f64, osFrequency);
+    return CAST(u64, CAST(f64, end - start) / elapsedSeconds);
+}
+
+u64 GetCpuFrequency()
+{
+    static u64 cpuFrequency = 0;
+
+    if(cpuFrequency == 0)
+    {
+        cpuFrequency = GetCpuFrequencyFromCpuid();
+    }
+
+    if(cpuFrequency == 0)
+    {
+        cpuFrequency = GetCpuFrequencyFromOs();
+    }
+
+    if(cpuFrequency == 0)
+    {
+        cpuFrequency = CalibrateCpuFrequency();
+    }
+
+    return cpuFrequency;
 }
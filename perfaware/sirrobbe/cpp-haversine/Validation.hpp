@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "Core.hpp"
+
+/*
+ * Compares every computed distance against its reference from results.bin
+ * while the sum is computed. The reference values are read from a mapping of
+ * the file, one at a time next to the inputs, so no second copy of all the
+ * distances is ever made.
+ */
+struct PairValidation
+{
+    u64 MismatchCount;
+    u64 FirstMismatch;
+    f64 FirstMismatchValue;
+    f64 FirstMismatchExpected;
+
+    f64 MaxAbsError;
+    f64 SumAbsError;
+    u64 MaxUlpError;
+};
+
+// NOTE: Maps the bits to integers that are ordered like the doubles, so the difference of
+//       two of them is the number of representable doubles in between.
+inline u64 GetOrderedBits(f64 value)
+{
+    u64 bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits >> 63) != 0 ? ~bits : bits | (1ull << 63);
+}
+
+inline u64 GetUlpDistance(f64 a, f64 b)
+{
+    u64 orderedA = GetOrderedBits(a);
+    u64 orderedB = GetOrderedBits(b);
+    return orderedA > orderedB ? orderedA - orderedB : orderedB - orderedA;
+}
+
+inline void ValidatePair(PairValidation* validation, u64 index, f64 value, f64 expected)
+{
+    f64 absError = fabs(value - expected);
+    validation->SumAbsError += absError;
+    if(absError > validation->MaxAbsError)
+    {
+        validation->MaxAbsError = absError;
+    }
+
+    u64 ulpError = GetUlpDistance(value, expected);
+    if(ulpError == 0)
+    {
+        return;
+    }
+
+    if(ulpError > validation->MaxUlpError)
+    {
+        validation->MaxUlpError = ulpError;
+    }
+
+    if(validation->MismatchCount == 0)
+    {
+        validation->FirstMismatch = index;
+        validation->FirstMismatchValue = value;
+        validation->FirstMismatchExpected = expected;
+    }
+
+    validation->MismatchCount++;
+}
+
+inline void PrintValidation(const PairValidation* validation, u64 pairCount)
+{
+    f64 meanAbsError = pairCount != 0 ? validation->SumAbsError / CAST(f64, pairCount) : 0.0;
+
+    printf("max abs error: %e\n", validation->MaxAbsError);
+    printf("mean abs error: %e\n", meanAbsError);
+    printf("max ulp error: %llu\n", CAST(unsigned long long, validation->MaxUlpError));
+
+    if(validation->MismatchCount == 0)
+    {
+        printf("mismatches: none\n");
+        return;
+    }
+
+    printf("mismatches: %llu, first at pair %llu (%.17f, expected %.17f)\n",
+           CAST(unsigned long long, validation->MismatchCount),
+           CAST(unsigned long long, validation->FirstMismatch),
+           validation->FirstMismatchValue,
+           validation->FirstMismatchExpected);
+}
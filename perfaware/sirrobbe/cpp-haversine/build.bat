@@ -13,4 +13,8 @@ call cl -O2 -nologo -Zi -EHsc -FC -std:c++20 ..\main.cpp -Fehaversine_msvc_relea
 
 echo clang release
 call clang -O3 -g -fuse-ld=lld -std=c++20 ..\main.cpp -o haversine_clang_release.exe
+
+echo string benchmark
+call cl -O2 -arch:AVX2 -nologo -Zi -EHsc -FC -std:c++20 ..\StringBenchmark.cpp -Festring_benchmark_msvc_release.exe
+call clang -O3 -mavx2 -g -fuse-ld=lld -std=c++20 ..\StringBenchmark.cpp -o string_benchmark_clang_release.exe
 popd
@@ -0,0 +1,12 @@
+#!/bin/sh
+mkdir -p build
+cd build
+
+echo clang debug
+clang++ -g -std=c++20 -pthread ../main.cpp -o haversine_clang_debug
+
+echo clang release
+clang++ -O3 -g -std=c++20 -pthread ../main.cpp -o haversine_clang_release
+
+echo string benchmark
+clang++ -O3 -mavx2 -g -std=c++20 ../StringBenchmark.cpp -o string_benchmark_clang_release
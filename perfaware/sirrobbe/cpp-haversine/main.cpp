@@ -3,9 +3,18 @@
 #include <cstdio>
 #include <string.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "BinaryFormat.hpp"
+#include "BlockChecksums.hpp"
+#include "Format.cpp"
 #include "Json.h"
+#include "MappedFile.cpp"
 #include "Timing.cpp"
 #include "Profiling.cpp"
+#include "Validation.hpp"
 
 static f64 DegToRad(f64 deg);
 static f64 Square(f64 x);
@@ -13,124 +22,273 @@ static f64 Haversine(f64 x0, f64 y0, f64 x1, f64 y1, f64 radius);
 
 static char* ReadFile(const char* name, bool isBinary);
 
-static u64 s_RngState = 0;
-static f64 UniformRange(f64 min, f64 max);
+struct RandomSeries
+{
+  u64 State;
+};
+
+static RandomSeries SeedSeries(u64 seed, u64 stream);
+static f64 UniformRange(RandomSeries* series, f64 min, f64 max);
+
+/*
+ * The generator splits the pairs into fixed blocks and every block draws from
+ * its own random series, seeded from the seed and the block index. A block
+ * comes out the same no matter which thread generates it, and the blocks are
+ * written strictly in order, so the files do not depend on the thread count.
+ * Clusters are numbered over the whole file and get their own series as well.
+ */
+constexpr i32 GenerateBlockPairs = CAST(i32, BLOCK_CHECKSUM_PAIRS);
+
+// NOTE: Four "-180.00000000000000000" plus the keys, with room to spare.
+constexpr i32 MaxPairTextLength = 192;
+
+constexpr i32 ClusterCount = 16;
+
+struct GenerateJob
+{
+  i32 Pairs;
+  u64 Seed;
+  bool Cluster;
+  i32 PairsPerCluster;
+  i32 BlockCount;
+
+  FILE* DataFile;
+  FILE* ResultsFile;
+
+  // NOTE: Only set when the binary columns were requested.
+  FILE* BinaryFile;
+  u64 ColumnStride;
+
+  // NOTE: One entry per block, only ever written by the thread generating that block.
+  BlockChecksum* Checksums;
+
+  std::mutex Mutex;
+  std::condition_variable BlockWritten;
+  i32 NextBlock;
+  f64 Sum;
+};
+
+static void GenerateBlocks(GenerateJob* job, i32 firstBlock, i32 threadCount);
+static char* AppendText(char* destination, const char* text);
+static void WriteAt(FILE* file, u64 offset, const void* data, u64 size);
 
 constexpr const char* GenerateCommand = "generate";
 constexpr const char* ComputeCommand = "compute";
 constexpr const char* UniformMode = "uniform";
 constexpr const char* ClusterMode = "cluster";
+constexpr const char* BinaryOption = "binary";
+constexpr const char* BlocksOption = "blocks";
 
 i32 main(i32 argc, char* argv[])
 {
   const char* command = argv[1];
 
+  bool useBlocks = false;
+  bool useBinary = false;
+  for(i32 index = 2; index < argc; index++)
+  {
+    useBlocks = useBlocks || strcmp(argv[index], BlocksOption) == 0;
+    useBinary = useBinary || strcmp(argv[index], BinaryOption) == 0;
+  }
+
   if(strcmp(command, GenerateCommand) == 0)
   {
     i32 pairs = atoi(argv[2]);
-    s_RngState = strtoull(argv[3], nullptr, 10);
+    u64 seed = strtoull(argv[3], nullptr, 10);
     const char* mode = argv[4];
 
-    printf("Running generator:\nNumber of pairs: %d\nSeed: %lld\nMode: %s\n",
+    i32 threadCount = CAST(i32, std::thread::hardware_concurrency());
+    bool writeBinary = false;
+    for(i32 index = 5; index < argc; index++)
+    {
+      if(strcmp(argv[index], BinaryOption) == 0)
+      {
+        writeBinary = true;
+      }
+      else
+      {
+        threadCount = atoi(argv[index]);
+      }
+    }
+
+    GenerateJob job = {};
+    job.Pairs = pairs;
+    job.Seed = seed;
+    job.Cluster = strcmp(mode, ClusterMode) == 0;
+    job.PairsPerCluster = (pairs + ClusterCount - 1) / ClusterCount;
+    job.BlockCount = (pairs + GenerateBlockPairs - 1) / GenerateBlockPairs;
+
+    if(threadCount > job.BlockCount)
+    {
+      threadCount = job.BlockCount;
+    }
+
+    if(threadCount < 1)
+    {
+      threadCount = 1;
+    }
+
+    printf("Running generator:\nNumber of pairs: %d\nSeed: %llu\nMode: %s\nThreads: %d\n",
            pairs,
-           s_RngState,
-           mode);
+           CAST(unsigned long long, seed),
+           mode,
+           threadCount);
 
-    FILE* dataFile = fopen("data.json", "w");
-    FILE* resultsFile = fopen("results.bin", "wb");
-    f64 sum = 0.0;
+    job.DataFile = fopen("data.json", "w");
+    job.ResultsFile = fopen("results.bin", "wb");
+    job.Checksums = CAST(BlockChecksum*, calloc(CAST(size_t, job.BlockCount) + 1, sizeof(BlockChecksum)));
+
+    BinaryPairsHeader header = {};
+    header.Magic = BINARY_PAIRS_MAGIC;
+    header.PairCount = CAST(u64, pairs);
+    header.Seed = seed;
+    header.ColumnStride = GetBinaryColumnStride(CAST(u64, pairs));
+
+    if(writeBinary)
+    {
+      job.BinaryFile = fopen("data.bin", "wb");
+      job.ColumnStride = header.ColumnStride;
+    }
+
+    fprintf(job.DataFile, "{\n\t\"pairs\" :\n\t[\n");
+
+    std::thread* threads = new std::thread[threadCount];
+    for(i32 index = 0; index < threadCount; index++)
+    {
+      threads[index] = std::thread(GenerateBlocks, &job, index, threadCount);
+    }
+
+    for(i32 index = 0; index < threadCount; index++)
+    {
+      threads[index].join();
+    }
+    delete[] threads;
+
+    fprintf(job.DataFile, "\t]\n}\n");
+    fclose(job.DataFile);
+
+    f64 result = job.Sum / pairs;
+    printf("Result: %f\n", result);
+
+    fwrite(&result, sizeof(f64), 1, job.ResultsFile);
+    fclose(job.ResultsFile);
+
+    BlockChecksumHeader blocksHeader = {};
+    blocksHeader.Magic = BLOCK_CHECKSUM_MAGIC;
+    blocksHeader.PairCount = CAST(u64, pairs);
+    blocksHeader.BlockPairCount = BLOCK_CHECKSUM_PAIRS;
+    blocksHeader.BlockCount = CAST(u64, job.BlockCount);
+    blocksHeader.ExpectedResult = result;
+
+    FILE* blocksFile = fopen("blocks.bin", "wb");
+    fwrite(&blocksHeader, sizeof(blocksHeader), 1, blocksFile);
+    fwrite(job.Checksums, sizeof(BlockChecksum), CAST(size_t, job.BlockCount), blocksFile);
+    fclose(blocksFile);
+    free(job.Checksums);
+
+    // NOTE: The header is written last, once the expected result is known.
+    if(job.BinaryFile != nullptr)
+    {
+      header.ExpectedResult = result;
+      WriteAt(job.BinaryFile, 0, &header, sizeof(header));
+      fclose(job.BinaryFile);
+    }
+  }
+  else if(strcmp(command, ComputeCommand) == 0 && useBinary)
+  {
+    Profiling::Begin();
+    printf("Compute binary dataset\n");
+
+    // NOTE: Nothing is parsed or copied, the columns are used right out of the mapping.
+    MappedFile data = {};
+    {
+      PROFILE_BLOCK("Map binary data");
+      data = MapFile("data.bin");
+    }
+
+    BinaryPairsHeader* header = REINTERPRET(BinaryPairsHeader*, data.Data);
+    if(data.Size < sizeof(BinaryPairsHeader) ||
+       header->Magic != BINARY_PAIRS_MAGIC ||
+       header->ColumnStride != GetBinaryColumnStride(header->PairCount) ||
+       data.Size < GetBinaryColumnOffset(header->ColumnStride, BINARY_COLUMN_COUNT - 1, header->PairCount))
+    {
+      printf("data.bin is not a valid binary dataset\n");
+      UnmapFile(&data);
+      return 1;
+    }
 
-    fprintf(dataFile, "{\n\t\"pairs\" :\n\t[\n");
+    u64 pairCount = header->PairCount;
 
-    if(strcmp(mode, UniformMode) == 0)
+    // NOTE: With blocks.bin there is no text to hash, only the block sums get checked.
+    MappedFile results = {};
+    BlockCheck blockCheck = {};
+    bool checkBlocks = false;
     {
-      for(i32 index = 0; index < pairs; index++)
+      PROFILE_BLOCK("Map results");
+      if(useBlocks)
       {
-        f64 x0 = UniformRange(-180.0, 180.0);
-        f64 y0 = UniformRange(-90.0, 90.0);
-        f64 x1 = UniformRange(-180.0, 180.0);
-        f64 y1 = UniformRange(-90.0, 90.0);
+        checkBlocks = OpenBlockCheck(&blockCheck, "blocks.bin") && blockCheck.Header->PairCount == pairCount;
+        blockCheck.ExactSums = true;
+      }
+      else
+      {
+        results = MapFile("results.bin");
+      }
+    }
+
+    const f64* expectedDistances = REINTERPRET(const f64*, results.Data);
+    bool validatePairs = results.Size == (pairCount + 1) * sizeof(f64);
+    PairValidation validation = {};
+
+    const f64* x0s = REINTERPRET(const f64*, data.Data + GetBinaryColumnOffset(header->ColumnStride, BINARY_COLUMN_X0, 0));
+    const f64* y0s = REINTERPRET(const f64*, data.Data + GetBinaryColumnOffset(header->ColumnStride, BINARY_COLUMN_Y0, 0));
+    const f64* x1s = REINTERPRET(const f64*, data.Data + GetBinaryColumnOffset(header->ColumnStride, BINARY_COLUMN_X1, 0));
+    const f64* y1s = REINTERPRET(const f64*, data.Data + GetBinaryColumnOffset(header->ColumnStride, BINARY_COLUMN_Y1, 0));
+
+    f64 sum = 0.0;
+    {
+      PROFILE_BLOCK("Haversine compute");
+
+      for(u64 index = 0; index < pairCount; index++)
+      {
+        f64 distance = Haversine(x0s[index], y0s[index], x1s[index], y1s[index], 6372.8);
+        sum += distance;
 
-        // NOTE(Fabi): To be conform with json we are not allowed to have a trailing comma.
-        if(index == pairs - 1)
+        if(validatePairs)
         {
-          fprintf(dataFile, "\t\t{ \"x0\" : %.17f, \"y0\" : %.17f, \"x1\" : %.17f, \"y1\" : %.17f }\n",
-                x0,
-                y0,
-                x1,
-                y1);
+          ValidatePair(&validation, index, distance, expectedDistances[index]);
         }
-        else
+
+        if(checkBlocks)
         {
-          fprintf(dataFile, "\t\t{ \"x0\" : %.17f, \"y0\" : %.17f, \"x1\" : %.17f, \"y1\" : %.17f },\n",
-                x0,
-                y0,
-                x1,
-                y1);
+          AddBlockDistance(&blockCheck, index, distance);
         }
-
-        f64 distance = Haversine(x0, y0, x1, y1, 6372.8);
-        sum += distance;
-        fwrite(&distance, sizeof(f64), 1, resultsFile);
       }
     }
-    else if(strcmp(mode, ClusterMode) == 0)
+
     {
-      i32 index = 0;
-      i32 clusterCount = 16;
-      i32 pairsPerCluster = pairs / clusterCount;
+      PROFILE_BLOCK("Output");
+      f64 average = sum / CAST(f64, pairCount);
+      printf("result: %f\n", average);
+      printf("expected: %f\n", header->ExpectedResult);
 
-      for(i32 clusterIndex = 0; clusterIndex < clusterCount; clusterIndex++)
+      if(validatePairs)
       {
-        f64 xMin = UniformRange(-180.0, 175.0);
-        f64 xMax = UniformRange(xMin + 1, 180.0);
-        f64 yMin = UniformRange(-90.0, 85.0);
-        f64 yMax = UniformRange(yMin + 1, 90.0);
-
-        for(i32 pairIndex = 0; pairIndex < pairsPerCluster; pairIndex++)
-        {
-          f64 x0 = UniformRange(xMin, xMax);
-          f64 y0 = UniformRange(yMin, yMax);
-          f64 x1 = UniformRange(xMin, xMax);
-          f64 y1 = UniformRange(yMin, yMax);
-
-          // NOTE(Fabi): To be conform with json we are not allowed to have a trailing comma.
-          if(index == pairs - 1)
-          {
-            fprintf(dataFile,
-                    "\t\t{ \"x0\" : %.17f, \"y0\" : %.17f, \"x1\" : %.17f, \"y1\" : %.17f }\n",
-                    x0,
-                    y0,
-                    x1,
-                    y1);
-          } 
-          else
-          {
-            fprintf(dataFile,
-                    "\t\t{ \"x0\" : %.17f, \"y0\" : %.17f, \"x1\" : %.17f, \"y1\" : %.17f },\n",
-                    x0,
-                    y0,
-                    x1,
-                    y1);
-          }
-
-          f64 distance = Haversine(x0, y0, x1, y1, 6372.8);
-          sum += distance;
-          fwrite(&distance, sizeof(f64), 1, resultsFile);
-          index++;
-        }
+        PrintValidation(&validation, pairCount);
       }
 
+      if(checkBlocks)
+      {
+        PrintBlockCheck(&blockCheck);
+      }
     }
 
-    fprintf(dataFile, "\t]\n}\n");
-    fclose(dataFile);
-
-    f64 result = sum / pairs;
-    printf("Result: %f\n", result);
+    UnmapFile(&blockCheck.File);
+    UnmapFile(&results);
+    UnmapFile(&data);
 
-    fwrite(&result, sizeof(f64), 1, resultsFile);
-    fclose(resultsFile);
+    Profiling::End();
+    Profiling::PrintBlocks();
   }
   else if(strcmp(command, ComputeCommand) == 0)
   {
@@ -145,26 +303,49 @@ i32 main(i32 argc, char* argv[])
       printf("Reading data is finished\n");
     }
 
-    f64* results = nullptr;
+    // NOTE: Mapped instead of read, the validation walks through it next to the pairs.
+    //       With blocks.bin the text is hashed here, before the parser gets to it.
+    MappedFile results = {};
+    BlockCheck blockCheck = {};
+    bool checkBlocks = false;
     {
-      BlockProfiler resultsLoad("Load results");
-      results = reinterpret_cast<f64*>(ReadFile("results.bin", true));
+      BlockProfiler resultsLoad("Map results");
+      if(useBlocks)
+      {
+        checkBlocks = OpenBlockCheck(&blockCheck, "blocks.bin");
+        if(checkBlocks)
+        {
+          CheckBlockText(&blockCheck, data, strlen(data));
+        }
+      }
+      else
+      {
+        results = MapFile("results.bin");
+      }
       printf("Reading results is finished\n");
     }
     
 
     auto dataAsString = String(data);
     auto json = ParseJson(&dataAsString);
-    free(data);
+    dataAsString.Free();
 
+    // NOTE: The keys are resolved to their interned ids once, every lookup inside
+    //       the loop is an integer compare.
     f64 sum = 0.f;
-    auto pairsKey = ScopedString(const_cast<char*>("pairs"));
-    auto x0Key = ScopedString(const_cast<char*>("x0"));
-    auto y0Key = ScopedString(const_cast<char*>("y0"));
-    auto x1Key = ScopedString(const_cast<char*>("x1"));
-    auto y1Key = ScopedString(const_cast<char*>("y1"));
+    JsonKey pairsKey = FindJsonKey(String(const_cast<char*>("pairs")));
+    JsonKey x0Key = FindJsonKey(String(const_cast<char*>("x0")));
+    JsonKey y0Key = FindJsonKey(String(const_cast<char*>("y0")));
+    JsonKey x1Key = FindJsonKey(String(const_cast<char*>("x1")));
+    JsonKey y1Key = FindJsonKey(String(const_cast<char*>("y1")));
     auto pairs = json[pairsKey].Array;
 
+    u64 pairCount = CAST(u64, pairs.Count());
+    const f64* expectedDistances = REINTERPRET(const f64*, results.Data);
+    bool validatePairs = results.Size == (pairCount + 1) * sizeof(f64);
+    PairValidation validation = {};
+    checkBlocks = checkBlocks && blockCheck.Header->PairCount == pairCount;
+
     {
       BlockProfiler compute("Haversine compute");
 
@@ -177,19 +358,43 @@ i32 main(i32 argc, char* argv[])
         f64 y1 = pair[y1Key].Number;
 
         f64 distance = Haversine(x0, y0, x1, y1, 6372.8);
-        f64 expected = results[index];
-
         sum += distance;
+
+        if(validatePairs)
+        {
+          ValidatePair(&validation, CAST(u64, index), distance, expectedDistances[index]);
+        }
+
+        if(checkBlocks)
+        {
+          AddBlockDistance(&blockCheck, CAST(u64, index), distance);
+        }
       }
     }
 
     {
       BlockProfiler output("Output");
       f64 average = sum / pairs.Count();
-      f64 expectedResult = results[pairs.Count()];
       printf("result: %f\n", average);
-      printf("expected: %f\n", expectedResult);
-      free(results);
+
+      if(validatePairs)
+      {
+        printf("expected: %f\n", expectedDistances[pairCount]);
+        PrintValidation(&validation, pairCount);
+      }
+      else if(checkBlocks)
+      {
+        printf("expected: %f\n", blockCheck.Header->ExpectedResult);
+        PrintBlockCheck(&blockCheck);
+      }
+      else
+      {
+        printf("%s does not match the pairs, nothing to validate\n", useBlocks ? "blocks.bin" : "results.bin");
+      }
+
+      UnmapFile(&blockCheck.File);
+      UnmapFile(&results);
+      FreeJsonKeys();
     }
 
     Profiling::End();
@@ -231,19 +436,172 @@ f64 Haversine(f64 x0, f64 y0, f64 x1, f64 y1, f64 radius)
   return result;
 }
 
+// NOTE: The splitmix64 finalizer spreads neighbouring streams apart. Xorshift
+//       must never be seeded with 0, it would only ever return 0.
+RandomSeries SeedSeries(u64 seed, u64 stream)
+{
+  u64 state = seed + (stream + 1) * 0x9E3779B97F4A7C15ULL;
+  state = (state ^ (state >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  state = (state ^ (state >> 27)) * 0x94D049BB133111EBULL;
+  state = state ^ (state >> 31);
+
+  RandomSeries series = {};
+  series.State = state != 0 ? state : 0x9E3779B97F4A7C15ULL;
+  return series;
+}
+
 // Algorithm "xor" from p. 4 of Marsaglia, "Xorshift RNGs"
-f64 UniformRange(f64 min, f64 max)
+f64 UniformRange(RandomSeries* series, f64 min, f64 max)
 {
-	s_RngState ^= s_RngState >> 12;
-	s_RngState ^= s_RngState << 25;
-	s_RngState ^= s_RngState >> 27;
+  series->State ^= series->State >> 12;
+  series->State ^= series->State << 25;
+  series->State ^= series->State >> 27;
 
-  u64 number = s_RngState * 0x2545F4914F6CDD1DULL;
+  u64 number = series->State * 0x2545F4914F6CDD1DULL;
 	
   f64 value = static_cast<f64>(number) / static_cast<f64>(UINT64_MAX);
   return min + (value * (max - min));
 }
 
+char* AppendText(char* destination, const char* text)
+{
+  size_t length = strlen(text);
+  memcpy(destination, text, length);
+  return destination + length;
+}
+
+void GenerateBlocks(GenerateJob* job, i32 firstBlock, i32 threadCount)
+{
+  char* text = CAST(char*, malloc(CAST(size_t, GenerateBlockPairs) * MaxPairTextLength));
+  f64* distances = CAST(f64*, malloc(GenerateBlockPairs * sizeof(f64)));
+
+  f64* columns[BINARY_COLUMN_COUNT] = {};
+  if(job->BinaryFile != nullptr)
+  {
+    for(u32 column = 0; column < BINARY_COLUMN_COUNT; column++)
+    {
+      columns[column] = CAST(f64*, malloc(GenerateBlockPairs * sizeof(f64)));
+    }
+  }
+
+  for(i32 blockIndex = firstBlock; blockIndex < job->BlockCount; blockIndex += threadCount)
+  {
+    i32 first = blockIndex * GenerateBlockPairs;
+    i32 onePastLast = first + GenerateBlockPairs;
+    if(onePastLast > job->Pairs)
+    {
+      onePastLast = job->Pairs;
+    }
+
+    // NOTE: Even streams belong to the blocks, odd streams to the clusters.
+    RandomSeries series = SeedSeries(job->Seed, 2 * CAST(u64, blockIndex));
+
+    i32 clusterIndex = -1;
+    f64 xMin = -180.0;
+    f64 xMax = 180.0;
+    f64 yMin = -90.0;
+    f64 yMax = 90.0;
+
+    char* at = text;
+    f64 sum = 0.0;
+    u64 textHash = 0;
+
+    for(i32 index = first; index < onePastLast; index++)
+    {
+      if(job->Cluster && clusterIndex != index / job->PairsPerCluster)
+      {
+        clusterIndex = index / job->PairsPerCluster;
+
+        RandomSeries clusterSeries = SeedSeries(job->Seed, 2 * CAST(u64, clusterIndex) + 1);
+        xMin = UniformRange(&clusterSeries, -180.0, 175.0);
+        xMax = UniformRange(&clusterSeries, xMin + 1, 180.0);
+        yMin = UniformRange(&clusterSeries, -90.0, 85.0);
+        yMax = UniformRange(&clusterSeries, yMin + 1, 90.0);
+      }
+
+      f64 x0 = UniformRange(&series, xMin, xMax);
+      f64 y0 = UniformRange(&series, yMin, yMax);
+      f64 x1 = UniformRange(&series, xMin, xMax);
+      f64 y1 = UniformRange(&series, yMin, yMax);
+
+      // NOTE: Same text as "\t\t{ \"x0\" : %.17f, \"y0\" : %.17f, \"x1\" : %.17f, \"y1\" : %.17f }".
+      at = AppendText(at, "\t\t");
+      char* pairText = at;
+      at = AppendText(at, "{ \"x0\" : ");
+      at = FormatFixed(at, x0, 17);
+      at = AppendText(at, ", \"y0\" : ");
+      at = FormatFixed(at, y0, 17);
+      at = AppendText(at, ", \"x1\" : ");
+      at = FormatFixed(at, x1, 17);
+      at = AppendText(at, ", \"y1\" : ");
+      at = FormatFixed(at, y1, 17);
+      at = AppendText(at, " }");
+      textHash = AddPairTextToHash(textHash, REINTERPRET(const byte*, pairText), at - pairText);
+
+      // NOTE: To be conform with json we are not allowed to have a trailing comma.
+      at = AppendText(at, index == job->Pairs - 1 ? "\n" : ",\n");
+
+      f64 distance = Haversine(x0, y0, x1, y1, 6372.8);
+      sum += distance;
+      distances[index - first] = distance;
+
+      if(job->BinaryFile != nullptr)
+      {
+        columns[BINARY_COLUMN_X0][index - first] = x0;
+        columns[BINARY_COLUMN_Y0][index - first] = y0;
+        columns[BINARY_COLUMN_X1][index - first] = x1;
+        columns[BINARY_COLUMN_Y1][index - first] = y1;
+      }
+    }
+
+    job->Checksums[blockIndex].Sum = sum;
+    job->Checksums[blockIndex].TextHash = textHash;
+
+    // NOTE: Only the thread holding the next block may write, the others wait with
+    //       their finished block. Adding the sums in block order as well keeps the
+    //       result bit-identical for every thread count.
+    std::unique_lock<std::mutex> lock(job->Mutex);
+    while(job->NextBlock != blockIndex)
+    {
+      job->BlockWritten.wait(lock);
+    }
+
+    fwrite(text, 1, CAST(size_t, at - text), job->DataFile);
+    fwrite(distances, sizeof(f64), CAST(size_t, onePastLast - first), job->ResultsFile);
+    job->Sum += sum;
+
+    if(job->BinaryFile != nullptr)
+    {
+      for(u32 column = 0; column < BINARY_COLUMN_COUNT; column++)
+      {
+        u64 offset = GetBinaryColumnOffset(job->ColumnStride, column, CAST(u64, first));
+        WriteAt(job->BinaryFile, offset, columns[column], CAST(u64, onePastLast - first) * sizeof(f64));
+      }
+    }
+
+    job->NextBlock++;
+    job->BlockWritten.notify_all();
+  }
+
+  for(u32 column = 0; column < BINARY_COLUMN_COUNT; column++)
+  {
+    free(columns[column]);
+  }
+
+  free(distances);
+  free(text);
+}
+
+void WriteAt(FILE* file, u64 offset, const void* data, u64 size)
+{
+#if defined(_WIN32)
+  _fseeki64(file, CAST(i64, offset), SEEK_SET);
+#else
+  fseeko(file, CAST(off_t, offset), SEEK_SET);
+#endif
+  fwrite(data, 1, CAST(size_t, size), file);
+}
+
 static char* ReadFile(const char* name, bool isBinary)
 {
   FILE* file = nullptr;
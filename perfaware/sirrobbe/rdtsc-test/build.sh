@@ -0,0 +1,9 @@
+#!/bin/sh
+mkdir -p build
+cd build
+
+echo clang debug
+clang++ -g -std=c++20 ../main.cpp -o rdtsc_clang_debug
+
+echo clang release
+clang++ -O3 -g -std=c++20 ../main.cpp -o rdtsc_clang_release
@@ -1,10 +1,167 @@
-#include "Types.h"
-#include "Windows.h"
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cstdio>
+
+#include "../cpp-haversine/Timing.cpp"
+
+#if !defined(_WIN32)
+#include <sys/time.h>
+#endif
+
+/*
+ * Measures every timer we could use for profiling on this machine. For each
+ * timer it reports:
+ *  - overhead:   CPU cycles one read costs, as the fastest of several batches
+ *  - resolution: the smallest step two consecutive reads ever differ by
+ * The TSC numbers are in cycles, everything else is converted to nanoseconds
+ * with the timer's own frequency so the timers can be compared directly.
+ */
+
+constexpr i32 BatchCount = 64;
+constexpr i32 ReadsPerBatch = 1024;
+constexpr i32 ResolutionReads = 1024 * 1024;
+
+struct TimerSource
+{
+  const char* Name;
+  u64 (*Read)();
+  u64 (*Frequency)();
+};
+
+static u64 ReadRdtsc()
+{
+  return GetCpuTime();
+}
+
+static u64 ReadRdtscp()
+{
+  u32 processor = 0;
+  return __rdtscp(&processor);
+}
+
+#if !defined(_WIN32)
+static u64 ReadClock(clockid_t clock)
+{
+  timespec time = {};
+  clock_gettime(clock, &time);
+  return CAST(u64, time.tv_sec) * 1000 * 1000 * 1000 + CAST(u64, time.tv_nsec);
+}
+
+static u64 ReadMonotonic()
+{
+  return ReadClock(CLOCK_MONOTONIC);
+}
+
+static u64 ReadMonotonicRaw()
+{
+  return ReadClock(CLOCK_MONOTONIC_RAW);
+}
+
+static u64 ReadGetTimeOfDay()
+{
+  timeval time = {};
+  gettimeofday(&time, nullptr);
+  return CAST(u64, time.tv_sec) * 1000 * 1000 + CAST(u64, time.tv_usec);
+}
+
+static u64 GetNanosecondFrequency()
+{
+  return 1000 * 1000 * 1000;
+}
+
+static u64 GetMicrosecondFrequency()
+{
+  return 1000 * 1000;
+}
+#endif
+
+static u64 MeasureOverhead(u64 (*read)())
+{
+  // NOTE: The volatile sink keeps the compiler from dropping the reads.
+  static volatile u64 sink = 0;
+
+  u64 minimum = U64_MAX;
+  for(i32 batch = 0; batch < BatchCount; batch++)
+  {
+    u64 start = GetCpuTime();
+    for(i32 index = 0; index < ReadsPerBatch; index++)
+    {
+      sink = sink + read();
+    }
+    u64 elapsed = GetCpuTime() - start;
+
+    if(elapsed < minimum)
+    {
+      minimum = elapsed;
+    }
+  }
+
+  return minimum;
+}
+
+static u64 MeasureResolution(u64 (*read)())
+{
+  u64 smallestStep = U64_MAX;
+  u64 previous = read();
+
+  for(i32 index = 0; index < ResolutionReads; index++)
+  {
+    u64 current = read();
+    if(current != previous)
+    {
+      u64 step = current - previous;
+      if(step < smallestStep)
+      {
+        smallestStep = step;
+      }
+      previous = current;
+    }
+  }
+
+  return smallestStep;
+}
 
 i32 main(i32 argc, char* argv[])
 {
-  LARGE_INTEGER counter = {};
-  QueryPerformanceCounter(&counter);
+  UNUSED(argc);
+  UNUSED(argv);
+
+  u64 cpuFrequency = GetCpuFrequency();
+  f64 cpuFrequencyInGHz = CAST(f64, cpuFrequency) / (1000.0 * 1000.0 * 1000.0);
+  printf("TSC frequency: %llu (%.4fGHz)\n\n", CAST(unsigned long long, cpuFrequency), cpuFrequencyInGHz);
+
+  TimerSource sources[] =
+  {
+    {"rdtsc", ReadRdtsc, GetCpuFrequency},
+    {"rdtscp", ReadRdtscp, GetCpuFrequency},
+#if defined(_WIN32)
+    {"QueryPerformanceCounter", GetOsTime, GetOsTimerFrequency},
+#else
+    {"CLOCK_MONOTONIC_RAW", ReadMonotonicRaw, GetNanosecondFrequency},
+    {"CLOCK_MONOTONIC", ReadMonotonic, GetNanosecondFrequency},
+    {"gettimeofday", ReadGetTimeOfDay, GetMicrosecondFrequency},
+#endif
+  };
+
+  printf("%-24s %16s %16s %16s %16s\n", "timer", "frequency", "cycles/read", "ns/read", "resolution (ns)");
+
+  for(i32 index = 0; index < CAST(i32, ARRAY_LENGTH(sources)); index++)
+  {
+    TimerSource* source = &sources[index];
+
+    f64 cyclesPerRead = CAST(f64, MeasureOverhead(source->Read)) / ReadsPerBatch;
+    f64 nanosecondsPerRead = cyclesPerRead / cpuFrequencyInGHz;
+
+    u64 frequency = source->Frequency();
+    f64 resolution = CAST(f64, MeasureResolution(source->Read)) * 1000.0 * 1000.0 * 1000.0 / CAST(f64, frequency);
+
+    printf("%-24s %16llu %16.1f %16.2f %16.2f\n",
+           source->Name,
+           CAST(unsigned long long, frequency),
+           cyclesPerRead,
+           nanosecondsPerRead,
+           resolution);
+  }
 
-  return counter.LowPart;
+  return 0;
 }